@@ -4,21 +4,33 @@
 
 	Created by Pasin Manurangsi, 2025-01-08
 	Modified by Luka Bond, 2025-01-25
+
+	Usage: ./vipTaxi [--stats] < input  (--stats prints party wait percentiles at the end)
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
+#include <sched.h>
+
+#include "../../Common/latencyHistogram.h"
 
-#define MAX_STACK_SIZE 5
+#define MAX_RANK 4095 /* Ranks 0 - MAX_RANK are accepted */
+#define NUM_RANKS (MAX_RANK + 1)
+#define BITMAP_WORDS (NUM_RANKS / 64) /* At most 64 words, so one summary word covers them */
+#define SLAB_OBJECTS 256 /* Objects carved out of each slab */
+#define INDEX_INITIAL_SIZE 64 /* Must be a power of two */
+#define CACHE_LINE_SIZE 64
 
 /* --------------- Data structures --------------- */
 
-/* Singly linked list node */
+/* Doubly linked list node, also serves as the handle used to cancel a party */
 typedef struct _node
 {
 	void* data;
 	struct _node* nextNode;
+	struct _node* prevNode;
 } node_t;
 
 /* Linked List */
@@ -35,25 +47,166 @@ typedef struct _rankQueue
 	int rank;
 } rankQueue_t;
 
-/* Custom stack */
-typedef struct _stack
+/* Priority dispatcher: one FIFO queue per rank and a two-level bitmap of non-empty ranks */
+typedef struct _dispatcher
 {
-	rankQueue_t** arr; /* Pointer to the array */
-	int size;
-	int maxSize;
-} stack_t;
+	rankQueue_t* queues[NUM_RANKS]; /* NULL when no party of that rank is waiting */
+	unsigned long long summary; /* Bit w is set when rankBits[w] is non-zero */
+	unsigned long long rankBits[BITMAP_WORDS]; /* Bit (r % 64) of word (r / 64) is set when rank r is waiting */
+} dispatcher_t;
 
 /* Party/Group structure */
 typedef struct _party
 {
 	int amount;
 	char name[25];
+	int arrivalTime; /* Timestep at which the party joined the line */
+	int rank; /* The rank queue holding the party */
 
 } party_t;
 
+/* Name to node hash index (Linear probing, deleted cells hold delMarker) */
+typedef struct _nameindex
+{
+	node_t** table;
+	int size; /* Power of two */
+	int used; /* Live entries plus deleted markers */
+	int count; /* Live entries */
+} nameindex_t;
+
+/* Slab header, the objects follow it in the same allocation */
+typedef struct _slab
+{
+	struct _slab* nextSlab;
+} slab_t;
+
+/* Free-list allocator for objects of a single size, memory is reused and only released by freePool */
+typedef struct _pool
+{
+	size_t objectSize;
+	void* freeList; /* Free objects, linked through their first word */
+	slab_t* slabs; /* Every slab allocated so far */
+	long long requests; /* poolAlloc calls (One calloc each without the pool) */
+	long long heapAllocations; /* Slabs allocated from the heap */
+} pool_t;
+
+/* Queueing latency instrumentation, in timesteps */
+typedef struct _queuestats
+{
+	histogram_t partyWait; /* Time from party arrival to pick up */
+	int queueDepth; /* Parties currently waiting over all ranks */
+	int maxQueueDepth; /* Most parties waiting at once */
+	int emptyTaxis; /* Taxis that left without a party (VIP taxis never queue) */
+} queuestats_t;
+
+/* Slot of a lock-free rank queue, the sequence number tells whether it is ready to be written or read */
+typedef struct _rankcell
+{
+	atomic_size_t sequence;
+	party_t party;
+} rankcell_t;
+
+/* Bounded lock-free multi-producer multi-consumer queue of one rank */
+typedef struct _lfqueue
+{
+	_Atomic(rankcell_t*) cells; /* Allocated by the first party of the rank */
+	_Alignas(CACHE_LINE_SIZE) atomic_size_t enqueuePos;
+	_Alignas(CACHE_LINE_SIZE) atomic_size_t dequeuePos;
+	_Alignas(CACHE_LINE_SIZE) atomic_long pending; /* Published parties not yet claimed by a taxi */
+} lfqueue_t;
+
+/* Thread-safe priority dispatcher: one lock-free queue per rank and an atomic occupancy bitmap */
+typedef struct _concurrentdispatcher
+{
+	lfqueue_t queues[NUM_RANKS];
+	size_t rankCapacity; /* Cells per rank queue (Power of two) */
+	_Alignas(CACHE_LINE_SIZE) atomic_ullong summary; /* Bit w is set when rankBits[w] may be non-zero */
+	atomic_ullong rankBits[BITMAP_WORDS]; /* Bit (r % 64) of word (r / 64) is set when rank r may be waiting */
+} concurrentdispatcher_t;
+
 /* --------------- Global variables --------------- */
 
-stack_t queueStack = {NULL, 0, MAX_STACK_SIZE}; /* Stack of Queues */
+dispatcher_t dispatcher = { { NULL }, 0, { 0 } }; /* Queues of every rank */
+queuestats_t stats = { 0 };
+
+/* Object pools, reused across rank transitions */
+pool_t rankQueuePool = { sizeof(rankQueue_t), NULL, NULL, 0, 0 };
+pool_t listPool = { sizeof(linkedlist_t), NULL, NULL, 0, 0 };
+pool_t nodePool = { sizeof(node_t), NULL, NULL, 0, 0 };
+pool_t partyPool = { sizeof(party_t), NULL, NULL, 0, 0 };
+
+nameindex_t nameIndex = { NULL, 0, 0, 0 }; /* Waiting parties by name */
+node_t delMarker = { NULL, NULL, NULL }; /* Globally allocated, DO NOT FREE */
+
+/* --------------- Slab/free-list allocator implementation --------------- */
+
+/* 
+poolAlloc: Returns a zeroed object from the pool, carving a new slab when the free list is empty.
+@param _pool: Pointer to the pool
+@return: Pointer to the object
+*/
+void* poolAlloc(pool_t* _pool)
+{
+	if(_pool->freeList == NULL)
+	{
+		/* Objects are padded so the free list link stays pointer-aligned */
+		size_t stride = (_pool->objectSize + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+		slab_t* newSlab = malloc(sizeof(slab_t) + SLAB_OBJECTS * stride);
+		if(newSlab == NULL)
+		{
+			printf("Failed to allocate new slab\n");
+			exit(1);
+		}
+		newSlab->nextSlab = _pool->slabs;
+		_pool->slabs = newSlab;
+		++_pool->heapAllocations;
+
+		/* Thread every object of the slab onto the free list */
+		char* objects = (char*)(newSlab + 1);
+		for (int i = SLAB_OBJECTS - 1; i >= 0; --i)
+		{
+			void* object = objects + i * stride;
+			*(void**)object = _pool->freeList;
+			_pool->freeList = object;
+		}
+	}
+
+	void* object = _pool->freeList;
+	_pool->freeList = *(void**)object;
+	++_pool->requests;
+	memset(object, 0, _pool->objectSize);
+	return object;
+}
+
+/* 
+poolFree: Returns an object to the pool's free list.
+@param _pool: Pointer to the pool
+@param _object: Pointer to the object (NULL is ignored)
+*/
+void poolFree(pool_t* _pool, void* _object)
+{
+	if(_object == NULL)
+	{
+		return;
+	}
+	*(void**)_object = _pool->freeList;
+	_pool->freeList = _object;
+}
+
+/* 
+freePool: Releases every slab of the pool back to the heap.
+@param _pool: Pointer to the pool
+*/
+void freePool(pool_t* _pool)
+{
+	while(_pool->slabs != NULL)
+	{
+		slab_t* nextSlab = _pool->slabs->nextSlab;
+		free(_pool->slabs);
+		_pool->slabs = nextSlab;
+	}
+	_pool->freeList = NULL;
+}
 
 /* --------------- Linked list-based Queue implementation --------------- */
 
@@ -61,19 +214,16 @@ stack_t queueStack = {NULL, 0, MAX_STACK_SIZE}; /* Stack of Queues */
 Enqueue: Add data (of any type) to a queue.
 @param _data: Pointer to data (of any type) to be stored
 @param _queue: Pointer to the queue
+@return: Pointer to the new node (Handle for unlinkNode)
 */
-void enqueue(void* _data, linkedlist_t* _queue)
+node_t* enqueue(void* _data, linkedlist_t* _queue)
 {
-	node_t* newNode = calloc(1, sizeof(node_t));
-	if(newNode == NULL)
-	{
-		printf("Failed to allocate new node\n");
-		exit(1);
-	}
+	node_t* newNode = poolAlloc(&nodePool);
 
 	/* Filling node attributes */
 	newNode->data = _data; /* Fill data */
 	newNode->nextNode = NULL; /* No next node (new tail) */
+	newNode->prevNode = _queue->tail; /* Previous node is the current tail */
 	
 	if(_queue->tail != NULL)
 	{
@@ -87,6 +237,37 @@ void enqueue(void* _data, linkedlist_t* _queue)
 		_queue->head = newNode;
 	}
 	_queue->tail = newNode; /* Reassigning the tail*/
+	return newNode;
+}
+
+/* 
+unlinkNode: Remove a node from anywhere in a queue in O(1) and return it to the pool.
+@param _node: Pointer to the node
+@param _queue: Pointer to the queue holding the node
+*/
+void unlinkNode(node_t* _node, linkedlist_t* _queue)
+{
+	/* Bridge the neighbours, or move the head/tail if the node is at an end */
+	if(_node->prevNode != NULL)
+	{
+		(_node->prevNode)->nextNode = _node->nextNode;
+	}
+	else
+	{
+		_queue->head = _node->nextNode;
+	}
+
+	if(_node->nextNode != NULL)
+	{
+		(_node->nextNode)->prevNode = _node->prevNode;
+	}
+	else
+	{
+		_queue->tail = _node->prevNode;
+	}
+
+	/* Return node to the pool */
+	poolFree(&nodePool, _node);
 }
 
 /* 
@@ -101,17 +282,8 @@ void* dequeue(linkedlist_t* _queue)
 		return NULL;
 	}
 
-	node_t* prevHead = _queue->head;
 	void* item = (_queue->head)->data;
-	
-
-	/* Reassign new head */
-	_queue->head = (_queue->head)->nextNode;
-
-	/* Free and set old pointer to NULL*/
-	free(prevHead);
-	prevHead = NULL;
-
+	unlinkNode(_queue->head, _queue);
 	return item;
 }
 
@@ -129,199 +301,616 @@ void* front(linkedlist_t* _queue)
 	return (_queue->head)->data;
 }
 
-/* --------------- Array-based stack implementation --------------- */
+/* ---------- Hash table - Linear probing implementation ---------- */
 
 /* 
-push: Add data (of any type) to the top of the stack.
-@param _data: Pointer to data (of any type) to be stored
-@param _stack: Pointer to the stack
+hash: A polynomial string hash function.
+@param key: Pointer to string to be hashed
+@param size: Hash table size (Power of two)
+@return: Hash function output
 */
-void push(void* _data, stack_t* _stack)
+int hash(char* key, int size)
 {
-	if(_stack->size == _stack->maxSize)
+	unsigned int hash = 0;
+	for (int i = 0; key[i] != '\0'; ++i)
 	{
-		printf("Cannot add to stack, an overflow may occur\n");
-		return;
+		hash = hash * 31 + (unsigned char)key[i];
 	}
-	++_stack->size;
-	_stack->arr[(_stack->size) - 1] = _data;
+	hash ^= hash >> 16; /* Mix the high bits into the masked low bits */
+	return (int)(hash & (size - 1));
 }
 
 /* 
-pop: Remove data (of any type) from the top of stack and return it. 
-@param _stack: Pointer to the stack
-@return: Pointer to the allocated data
+nodeName: Returns the name of the party held by an index entry.
+@param _node: Pointer to the node
+@return: Pointer to the name
 */
-void* pop(stack_t* _stack)
-{	
-	if(_stack->size == 0)
+char* nodeName(node_t* _node)
+{
+	return ((party_t*)_node->data)->name;
+}
+
+/* 
+indexInsert: Insert a node into the name index, keyed by its party's name.
+	Deleted cells are not reused, so equal names are probed in arrival order.
+@param _node: Pointer to the node
+*/
+void indexInsert(node_t* _node)
+{
+	/* Rebuild once half of the cells are taken, doubling only if live entries need it */
+	if(2 * (nameIndex.used + 1) > nameIndex.size)
 	{
-		return NULL;
+		int newSize = (nameIndex.size == 0) ? INDEX_INITIAL_SIZE : nameIndex.size;
+		while(4 * (nameIndex.count + 1) > newSize)
+		{
+			newSize *= 2;
+		}
+
+		node_t** newTable = calloc(newSize, sizeof(node_t*));
+		if(newTable == NULL)
+		{
+			printf("Failed to allocate name index\n");
+			exit(1);
+		}
+
+		/* Reinsert live entries starting after an empty cell, so every probe run is
+		   walked from its start and equal names keep their arrival order */
+		int start = 0;
+		while(nameIndex.size > 0 && nameIndex.table[start] != NULL)
+		{
+			++start;
+		}
+		for (int i = 0; i < nameIndex.size; ++i)
+		{
+			node_t* entry = nameIndex.table[(start + i) & (nameIndex.size - 1)];
+			if(entry == NULL || entry == &delMarker)
+			{
+				continue;
+			}
+			int hashKey = hash(nodeName(entry), newSize);
+			while(newTable[hashKey] != NULL)
+			{
+				hashKey = (hashKey + 1) & (newSize - 1);
+			}
+			newTable[hashKey] = entry;
+		}
+
+		free(nameIndex.table);
+		nameIndex.table = newTable;
+		nameIndex.size = newSize;
+		nameIndex.used = nameIndex.count;
 	}
-	--_stack->size;
-	return _stack->arr[_stack->size - 1]; /* Extract pointer to the data */
+
+	int hashKey = hash(nodeName(_node), nameIndex.size);
+	while(nameIndex.table[hashKey] != NULL) /* Loop until cell is empty */
+	{
+		hashKey = (hashKey + 1) & (nameIndex.size - 1); /* Move to next cell */
+	}
+	nameIndex.table[hashKey] = _node;
+	++nameIndex.used;
+	++nameIndex.count;
 }
 
 /* 
-top: Return data (of any type) from the top of stack. 
-@param _stack: Pointer to the stack
-@return: Pointer to the allocated data
+indexFind: Search the name index for a waiting party.
+@param name: The party name
+@return: Pointer to the cell holding the first matching node, NULL if not found
 */
-void* top(stack_t* _stack)
-{	
-	if(_stack->size == 0)
+node_t** indexFind(char* name)
+{
+	if(nameIndex.size == 0)
 	{
 		return NULL;
 	}
-	return _stack->arr[_stack->size - 1]; /* Extract pointer to the data */
+
+	int hashKey = hash(name, nameIndex.size);
+	while(nameIndex.table[hashKey] != NULL) /* Loop until cell is empty */
+	{
+		node_t* entry = nameIndex.table[hashKey];
+		if(entry != &delMarker && !strcmp(nodeName(entry), name))
+		{
+			return &nameIndex.table[hashKey];
+		}
+		hashKey = (hashKey + 1) & (nameIndex.size - 1); /* Move to next cell */
+	}
+	return NULL;
+}
+
+/* 
+indexDelete: Remove a specific node from the name index.
+@param _node: Pointer to the node
+*/
+void indexDelete(node_t* _node)
+{
+	int hashKey = hash(nodeName(_node), nameIndex.size);
+	while(nameIndex.table[hashKey] != NULL)
+	{
+		if(nameIndex.table[hashKey] == _node)
+		{
+			nameIndex.table[hashKey] = &delMarker; /* Keeps later probes intact */
+			--nameIndex.count;
+			return;
+		}
+		hashKey = (hashKey + 1) & (nameIndex.size - 1);
+	}
+}
+
+/* --------------- Rank bitmap implementation --------------- */
+
+/* 
+markRank: Marks a rank as having waiting parties.
+@param rank: The rank (0 - MAX_RANK)
+*/
+void markRank(int rank)
+{
+	dispatcher.rankBits[rank >> 6] |= 1ULL << (rank & 63);
+	dispatcher.summary |= 1ULL << (rank >> 6);
+}
+
+/* 
+unmarkRank: Marks a rank as having no waiting parties.
+@param rank: The rank (0 - MAX_RANK)
+*/
+void unmarkRank(int rank)
+{
+	dispatcher.rankBits[rank >> 6] &= ~(1ULL << (rank & 63));
+	if(dispatcher.rankBits[rank >> 6] == 0)
+	{
+		dispatcher.summary &= ~(1ULL << (rank >> 6));
+	}
+}
+
+/* 
+highestRank: Finds the highest rank with waiting parties using two count-leading-zeros.
+@return: The highest waiting rank, -1 if no party is waiting
+*/
+int highestRank()
+{
+	if(dispatcher.summary == 0)
+	{
+		return -1;
+	}
+	int word = 63 - __builtin_clzll(dispatcher.summary);
+	int bit = 63 - __builtin_clzll(dispatcher.rankBits[word]);
+	return (word << 6) + bit;
 }
 
 /* --------------- Helper functions --------------- */
 
 /* 
-freeList: Helper function to free all of the contents from the linked list
+freeList: Helper function to return all of the parties in the linked list to their pool
 @param list: Pointer to the linked list
 */
 void freeList(linkedlist_t* list)
 {
 	while(list->head != NULL)
 	{
-		/* Dequeue frees each node already */
+		/* Dequeue releases each node already */
 		void* _data = dequeue(list); 
-		free(_data);
+		poolFree(&partyPool, _data);
 		_data = NULL;
 	}
 }
 
 /* 
-createQueue: Helper function to create rank queues. 
+createQueue: Helper function to create rank queues and register them with the dispatcher. 
 @param rank: The rank of the queue
 @return: Pointer to the queue
 */
 rankQueue_t* createRankQueue(int rank)
 {
-	rankQueue_t* newQueue = calloc(1, sizeof(rankQueue_t));
-	if(newQueue == NULL) 
-	{
-		printf("Failed to allocate new queue\n");
-		exit(1);
-	}
-
-	linkedlist_t* newList = calloc(1, sizeof(linkedlist_t));
-	if(newList == NULL) 
-	{
-		printf("Failed to allocate new linked list\n");
-		exit(1);
-	}
+	rankQueue_t* newQueue = poolAlloc(&rankQueuePool);
+	linkedlist_t* newList = poolAlloc(&listPool);
 
 	newQueue->list = newList;
 	newQueue->rank = rank;
 
-	/* Push new queue into the stack */
-	push(newQueue, &queueStack);
+	/* Register new queue with the dispatcher */
+	dispatcher.queues[rank] = newQueue;
+	markRank(rank);
 	return newQueue;
 }
 
 /* 
-createQueue: Helper function to free rank queues. 
+freeRankQueue: Helper function to free rank queues and unregister them from the dispatcher. 
 @param rankQueue: The pointer to the rank queue
 */
 void freeRankQueue(rankQueue_t* rankQueue)
 {
+	dispatcher.queues[rankQueue->rank] = NULL;
+	unmarkRank(rankQueue->rank);
+
 	linkedlist_t* list = rankQueue->list;
 	
 	/* Free all nodes from the list */
 	freeList(list);
 
-	/* Free pointer to struct containing list head and tail */
-	free(list);
+	/* Release struct containing list head and tail */
+	poolFree(&listPool, list);
 	list = NULL;
 
-	/* Free pointer to struct containg rank and list */
-	free(rankQueue);
+	/* Release struct containg rank and list */
+	poolFree(&rankQueuePool, rankQueue);
 	rankQueue = NULL;
 }
 
+/* --------------- Queueing latency instrumentation --------------- */
+
+
+/* 
+printStats: Prints the wait percentiles, maximum queue depth, empty taxis and allocation rates.
+@param events: The number of events handled
+*/
+void printStats(int events)
+{
+	histogram_t* wait = &stats.partyWait;
+	printf("Served: %lld groups, In line: %d groups\n", wait->total, stats.queueDepth);
+	printf("Party wait: p50 %d, p99 %d, p999 %d, max %d timesteps\n",
+		valueAtPercentile(wait, 50), valueAtPercentile(wait, 99), valueAtPercentile(wait, 99.9), wait->max);
+	printf("Max queue depth: %d parties, Empty taxis: %d\n", stats.maxQueueDepth, stats.emptyTaxis);
+
+	/* Requests are what used to be one calloc each, heap allocations are what the pools really did */
+	pool_t* pools[4] = { &rankQueuePool, &listPool, &nodePool, &partyPool };
+	long long requests = 0;
+	long long heapAllocations = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		requests += pools[i]->requests;
+		heapAllocations += pools[i]->heapAllocations;
+	}
+	double perEvent = (events > 0) ? 1.0 / events : 0.0;
+	printf("Allocations: %lld before pooling (%.3f per event), %lld after (%.3f per event)\n",
+		requests, requests * perEvent, heapAllocations, heapAllocations * perEvent);
+}
+
 /* --------------- Taxi/Party arrival --------------- */
 
 /* 
 taxiArrival	: Handles an arrival of a new taxi
+@param timestep: The current timestep
 */
-void taxiArrival()
+void taxiArrival(int timestep)
 {
-	rankQueue_t* topQueue = top(&queueStack);
-	if(topQueue == NULL) /* No parties of any rank*/
+	int rank = highestRank();
+	if(rank < 0) /* No parties of any rank*/
 	{
 		printf("Empty Queue\n");
+		++stats.emptyTaxis;
 		return;
 	}
 
+	rankQueue_t* topQueue = dispatcher.queues[rank];
 	linkedlist_t* partyList = topQueue->list;
+	indexDelete(partyList->head);
 	party_t* party = dequeue(partyList);
 
 	printf("Pick up party %s with %d people.\n", party->name, party->amount);
-	free(party);
+	recordValue(&stats.partyWait, timestep - party->arrivalTime);
+	--stats.queueDepth;
+	poolFree(&partyPool, party);
 	party = NULL;
 
 	if(partyList->head == NULL)
 	{
 		/* Remove queue if list is empty */
 		freeRankQueue(topQueue);
-		pop(&queueStack);
 	}
 }
 
 /* 
 partyArrival: Handles an arrival of a new party.
+@param rank: The rank of the party (0 - MAX_RANK)
 @param count: The number of people in the party
 @param partyName: The name of the party
+@param timestep: The current timestep
 */
-void partyArrival(int rank, int count, char partyName[])
+void partyArrival(int rank, int count, char partyName[], int timestep)
 {
-	rankQueue_t* topQueue = top(&queueStack);
-	if(topQueue == NULL) /* Stack is empty */
-	{
-		topQueue = createRankQueue(rank); /* Reassign stack head */
-	}
-
-	if(rank < topQueue->rank) /* Low priority */
+	if(rank < 0 || rank > MAX_RANK) /* Outside of the supported ranks */
 	{
 		printf("Rejected\n");
 		return;
 	}
-	else if(rank > topQueue->rank) /* High priority, create new queue */
+
+	rankQueue_t* rankQueue = dispatcher.queues[rank];
+	if(rankQueue == NULL) /* First waiting party of this rank */
 	{
-		topQueue = createRankQueue(rank); /* Reassign stack head */
+		rankQueue = createRankQueue(rank);
 	}
 	
-	/* Current rank = input rank */
-	party_t* newParty = calloc(1, sizeof(party_t));
-	if(newParty == NULL) 
-	{
-		printf("Failed to allocate new party\n");
-		exit(1);
-	}
+	party_t* newParty = poolAlloc(&partyPool);
 
 	newParty->amount = count;
 	strncpy(newParty->name, partyName, 20);
-	enqueue(newParty, topQueue->list);
+	newParty->arrivalTime = timestep;
+	newParty->rank = rank;
+	indexInsert(enqueue(newParty, rankQueue->list));
 	printf("Accepted\n");
+
+	if(++stats.queueDepth > stats.maxQueueDepth)
+	{
+		stats.maxQueueDepth = stats.queueDepth;
+	}
 }	
 
+/* 
+cancelParty: Removes a waiting party from the line in O(1).
+	With several waiting parties of the same name, the earliest to arrive is removed.
+@param partyName: The name of the party
+*/
+void cancelParty(char partyName[])
+{
+	/* Names are stored truncated to 20 characters */
+	char name[25] = { 0 };
+	strncpy(name, partyName, 20);
+
+	node_t** cell = indexFind(name);
+	if(cell == NULL)
+	{
+		printf("Not Found\n");
+		return;
+	}
+
+	node_t* node = *cell;
+	party_t* party = node->data;
+	rankQueue_t* rankQueue = dispatcher.queues[party->rank];
+
+	*cell = &delMarker;
+	--nameIndex.count;
+	unlinkNode(node, rankQueue->list);
+	poolFree(&partyPool, party);
+	--stats.queueDepth;
+	printf("Cancelled\n");
+
+	if(rankQueue->list->head == NULL)
+	{
+		/* Remove queue right away if it is now empty */
+		freeRankQueue(rankQueue);
+	}
+}
+
 /* 
 freeAll: Free the contents of the datastructures used 
 */
 void freeAll()
 {
-	for (int i = 0; i < queueStack.maxSize; ++i)
+	int rank = highestRank();
+	while(rank >= 0)
 	{
-		if(queueStack.arr[i] == NULL)
+		freeRankQueue(dispatcher.queues[rank]); /* Also clears the rank's bit */
+		rank = highestRank();
+	}
+
+	free(nameIndex.table);
+	nameIndex.table = NULL;
+}
+
+/* --------------- Concurrent per-rank dispatcher --------------- */
+
+/* 
+createConcurrentDispatcher: Allocates a thread-safe dispatcher, rank queues are allocated on first use.
+@param rankCapacity: The maximum number of waiting parties per rank (Rounded up to a power of two)
+@return: Pointer to the dispatcher
+*/
+concurrentdispatcher_t* createConcurrentDispatcher(size_t rankCapacity)
+{
+	concurrentdispatcher_t* newDispatcher = aligned_alloc(CACHE_LINE_SIZE, sizeof(concurrentdispatcher_t));
+	if(newDispatcher == NULL)
+	{
+		printf("Failed to allocate concurrent dispatcher\n");
+		exit(1);
+	}
+	memset(newDispatcher, 0, sizeof(concurrentdispatcher_t)); /* Zero is a valid initial state for every atomic */
+
+	newDispatcher->rankCapacity = 2;
+	while(newDispatcher->rankCapacity < rankCapacity)
+	{
+		newDispatcher->rankCapacity *= 2;
+	}
+	return newDispatcher;
+}
+
+/* 
+freeConcurrentDispatcher: Frees the dispatcher and every rank queue (No thread may still use it).
+@param _dispatcher: Pointer to the dispatcher
+*/
+void freeConcurrentDispatcher(concurrentdispatcher_t* _dispatcher)
+{
+	for (int i = 0; i < NUM_RANKS; ++i)
+	{
+		free(atomic_load(&_dispatcher->queues[i].cells));
+	}
+	free(_dispatcher);
+}
+
+/* 
+getCells: Returns the cells of a rank queue, installing them if this is the rank's first party.
+@param _dispatcher: Pointer to the dispatcher
+@param _queue: Pointer to the rank queue
+@return: Pointer to the cells
+*/
+rankcell_t* getCells(concurrentdispatcher_t* _dispatcher, lfqueue_t* _queue)
+{
+	rankcell_t* cells = atomic_load_explicit(&_queue->cells, memory_order_acquire);
+	if(cells != NULL)
+	{
+		return cells;
+	}
+
+	rankcell_t* newCells = malloc(_dispatcher->rankCapacity * sizeof(rankcell_t));
+	if(newCells == NULL)
+	{
+		printf("Failed to allocate rank queue\n");
+		exit(1);
+	}
+	for (size_t i = 0; i < _dispatcher->rankCapacity; ++i)
+	{
+		atomic_init(&newCells[i].sequence, i); /* Cell i is first writable when enqueuePos reaches i */
+	}
+
+	/* Another thread may have installed its cells first, keep theirs */
+	if(!atomic_compare_exchange_strong_explicit(&_queue->cells, &cells, newCells,
+		memory_order_acq_rel, memory_order_acquire))
+	{
+		free(newCells);
+		return cells;
+	}
+	return newCells;
+}
+
+/* 
+reserveRank: Installs a rank's queue ahead of its first party, keeping the allocation off the arrival path.
+@param _dispatcher: Pointer to the dispatcher
+@param rank: The rank (0 - MAX_RANK)
+*/
+void reserveRank(concurrentdispatcher_t* _dispatcher, int rank)
+{
+	getCells(_dispatcher, &_dispatcher->queues[rank]);
+}
+
+/* 
+setRankBit: Marks a rank as occupied in both bitmap levels.
+@param _dispatcher: Pointer to the dispatcher
+@param rank: The rank
+*/
+void setRankBit(concurrentdispatcher_t* _dispatcher, int rank)
+{
+	atomic_fetch_or(&_dispatcher->rankBits[rank >> 6], 1ULL << (rank & 63));
+	atomic_fetch_or(&_dispatcher->summary, 1ULL << (rank >> 6));
+}
+
+/* 
+clearSummaryBit: Clears the summary bit of a bitmap word, setting it again if the word
+	was filled concurrently. Bits can be stale-set, never stale-clear.
+@param _dispatcher: Pointer to the dispatcher
+@param word: The index of the bitmap word
+*/
+void clearSummaryBit(concurrentdispatcher_t* _dispatcher, int word)
+{
+	atomic_fetch_and(&_dispatcher->summary, ~(1ULL << word));
+	if(atomic_load(&_dispatcher->rankBits[word]) != 0)
+	{
+		atomic_fetch_or(&_dispatcher->summary, 1ULL << word);
+	}
+}
+
+/* 
+clearRankBit: Marks a rank as empty, setting it again if a party arrived concurrently.
+@param _dispatcher: Pointer to the dispatcher
+@param rank: The rank
+*/
+void clearRankBit(concurrentdispatcher_t* _dispatcher, int rank)
+{
+	unsigned long long rankBit = 1ULL << (rank & 63);
+	if(atomic_fetch_and(&_dispatcher->rankBits[rank >> 6], ~rankBit) == rankBit)
+	{
+		clearSummaryBit(_dispatcher, rank >> 6); /* The word became zero */
+	}
+
+	if(atomic_load(&_dispatcher->queues[rank].pending) > 0)
+	{
+		setRankBit(_dispatcher, rank);
+	}
+}
+
+/* 
+concurrentPartyArrival: Adds a party to its rank's queue (Thread-safe).
+	Waits for a taxi to free a cell when the rank's queue is full.
+@param _dispatcher: Pointer to the dispatcher
+@param _party: Pointer to the party (Copied into the queue, rank must be 0 - MAX_RANK)
+*/
+void concurrentPartyArrival(concurrentdispatcher_t* _dispatcher, const party_t* _party)
+{
+	lfqueue_t* queue = &_dispatcher->queues[_party->rank];
+	rankcell_t* cells = getCells(_dispatcher, queue);
+	size_t mask = _dispatcher->rankCapacity - 1;
+
+	size_t pos = atomic_load_explicit(&queue->enqueuePos, memory_order_relaxed);
+	for (;;)
+	{
+		rankcell_t* cell = &cells[pos & mask];
+		long diff = (long)atomic_load_explicit(&cell->sequence, memory_order_acquire) - (long)pos;
+		if(diff == 0) /* Cell is free, try to claim it */
 		{
+			if(atomic_compare_exchange_weak_explicit(&queue->enqueuePos, &pos, pos + 1,
+				memory_order_relaxed, memory_order_relaxed))
+			{
+				cell->party = *_party;
+				atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release); /* Publish */
+				break;
+			}
+		}
+		else if(diff < 0) /* Queue is full */
+		{
+			sched_yield();
+			pos = atomic_load_explicit(&queue->enqueuePos, memory_order_relaxed);
+		}
+		else /* Another producer claimed it, reload the position */
+		{
+			pos = atomic_load_explicit(&queue->enqueuePos, memory_order_relaxed);
+		}
+	}
+
+	/* Only count the party once it is published, so a claiming taxi always finds it */
+	if(atomic_fetch_add(&queue->pending, 1) == 0)
+	{
+		setRankBit(_dispatcher, _party->rank);
+	}
+}
+
+/* 
+concurrentTaxiArrival: Picks up the front party of the highest occupied rank (Thread-safe).
+@param _dispatcher: Pointer to the dispatcher
+@param _party: Filled with the picked up party
+@return: 1 if a party was picked up, 0 if no party is waiting
+*/
+int concurrentTaxiArrival(concurrentdispatcher_t* _dispatcher, party_t* _party)
+{
+	for (;;)
+	{
+		unsigned long long summary = atomic_load(&_dispatcher->summary);
+		if(summary == 0)
+		{
+			return 0;
+		}
+
+		int word = 63 - __builtin_clzll(summary);
+		unsigned long long bits = atomic_load(&_dispatcher->rankBits[word]);
+		if(bits == 0) /* Stale summary bit */
+		{
+			clearSummaryBit(_dispatcher, word);
 			continue;
 		}
+		int rank = (word << 6) + (63 - __builtin_clzll(bits));
+		lfqueue_t* queue = &_dispatcher->queues[rank];
 
-		freeRankQueue(queueStack.arr[i]);
-		queueStack.arr[i] = NULL;
+		/* Claim one published party of this rank */
+		long pending = atomic_load(&queue->pending);
+		while(pending > 0 && !atomic_compare_exchange_weak(&queue->pending, &pending, pending - 1))
+		{
+		}
+		if(pending <= 0) /* Stale bit, clear it and look again */
+		{
+			clearRankBit(_dispatcher, rank);
+			continue;
+		}
+		if(pending == 1)
+		{
+			clearRankBit(_dispatcher, rank); /* Took the last one */
+		}
+
+		/* The claim guarantees a published cell, FIFO order comes from dequeuePos */
+		rankcell_t* cells = atomic_load_explicit(&queue->cells, memory_order_acquire);
+		size_t mask = _dispatcher->rankCapacity - 1;
+		size_t pos = atomic_fetch_add_explicit(&queue->dequeuePos, 1, memory_order_relaxed);
+		rankcell_t* cell = &cells[pos & mask];
+		while(atomic_load_explicit(&cell->sequence, memory_order_acquire) != pos + 1)
+		{
+			sched_yield(); /* A slower claimer of the previous lap has not released the cell yet */
+		}
+		*_party = cell->party;
+		atomic_store_explicit(&cell->sequence, pos + mask + 1, memory_order_release); /* Free for the next lap */
+		return 1;
 	}
 }
 
@@ -333,28 +922,40 @@ reading from the standard input and handling taxi / party arrivals
 */
 int main(int argc, char* argv[])
 {
+ 	int printQueueStats = (argc > 1 && strcmp(argv[1], "--stats") == 0); /* Latency summary at the end */
  	int timesteps; /* The total number of timesteps */
- 	char input[10]; /* For the input prefix "Taxi" or "Party" */
+ 	char input[10]; /* For the input prefix "Taxi", "Party" or "Cancel" */
  	char name[25]; /* The party name */
  	int rank; /* The party's status */
  	int count; /* The number of people in the party */
 
-	rankQueue_t* queueArr[MAX_STACK_SIZE] = { NULL }; /* Array of pointers to queues */
-	queueStack.arr = queueArr; /* Set stack array pointer */
-
  	scanf("%d", &timesteps);
  	for (int i = 0 ; i < timesteps ; i ++)
  	{
  		scanf("\n%s", input);
  		if (strcmp(input, "Taxi") == 0)
  		{
- 			taxiArrival();
+ 			taxiArrival(i);
+ 		}
+ 		else if (strcmp(input, "Cancel") == 0)
+ 		{
+ 			scanf(" %s", name);
+ 			cancelParty(name);
  		}
  		else
  		{
  			scanf(" %d %d %s", &rank, &count, name);
- 			partyArrival(rank, count, name);
+ 			partyArrival(rank, count, name, i);
  		}
  	}
+ 	if(printQueueStats)
+ 	{
+ 		printStats(timesteps);
+ 	}
  	freeAll();
+ 	freePool(&rankQueuePool);
+ 	freePool(&listPool);
+ 	freePool(&nodePool);
+ 	freePool(&partyPool);
+ 	return 0;
 }
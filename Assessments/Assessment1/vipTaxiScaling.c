@@ -0,0 +1,204 @@
+/*
+	VIP Taxi Concurrent Dispatcher Scaling Benchmark
+	Several gate threads submit parties and pull taxis from the lock-free
+	per-rank dispatcher in vipTaxi.c, reporting pick ups/sec for
+	1, 2, 4, ... up to the requested number of threads.
+
+	Build: gcc -O2 -pthread -o vipTaxiScaling vipTaxiScaling.c
+	Usage: ./vipTaxiScaling [maxThreads] [numEvents]
+*/
+
+#define main vipTaxiMain
+#include "vipTaxi.c"
+#undef main
+
+#include <pthread.h>
+#include <time.h>
+
+#define BENCH_RANKS 64 /* Ranks used by the generated stream */
+
+/* Work handed to one gate thread */
+typedef struct _worker
+{
+	pthread_t thread;
+	concurrentdispatcher_t* dispatcher;
+	const int* events; /* -1 for a taxi, otherwise the rank of an arriving party */
+	int* picked; /* Rank picked up by each taxi event, -1 if none was waiting */
+	int numEvents;
+	int threadIndex;
+	int numThreads;
+	long pickups; /* Parties picked up by this thread's taxis */
+	int fifoViolations; /* Only meaningful with a single thread */
+} worker_t;
+
+/*
+elapsedSeconds: Returns the seconds elapsed between two timestamps.
+@param start: The earlier timestamp
+@param end: The later timestamp
+@return: Elapsed time in seconds
+*/
+double elapsedSeconds(struct timespec start, struct timespec end)
+{
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/*
+countRankViolations: Replays the stream in order and counts the taxis that did not pick up
+	from the highest rank with a waiting party at that point (Single-threaded runs only).
+@param events: The event stream
+@param picked: The rank each taxi event picked up
+@param numEvents: The number of events
+@return: The number of taxis that skipped a higher waiting rank or left one waiting
+*/
+int countRankViolations(const int* events, const int* picked, int numEvents)
+{
+	int waiting[BENCH_RANKS] = { 0 };
+	int violations = 0;
+	for (int i = 0; i < numEvents; ++i)
+	{
+		if(events[i] >= 0)
+		{
+			++waiting[events[i]];
+			continue;
+		}
+
+		int highest = BENCH_RANKS - 1;
+		while(highest >= 0 && waiting[highest] == 0)
+		{
+			--highest;
+		}
+		if(picked[i] != highest)
+		{
+			++violations;
+		}
+		if(picked[i] >= 0)
+		{
+			--waiting[picked[i]];
+		}
+	}
+	return violations;
+}
+
+/*
+runWorker: Submits every numThreads-th event of the stream to the dispatcher.
+@param _arg: Pointer to the worker
+*/
+void* runWorker(void* _arg)
+{
+	worker_t* worker = _arg;
+	int lastArrival[BENCH_RANKS];
+	for (int r = 0; r < BENCH_RANKS; ++r)
+	{
+		lastArrival[r] = -1;
+	}
+
+	party_t party = { 0 };
+	strcpy(party.name, "Party");
+	for (int i = worker->threadIndex; i < worker->numEvents; i += worker->numThreads)
+	{
+		if(worker->events[i] >= 0)
+		{
+			party.rank = worker->events[i];
+			party.amount = 1 + (i & 3);
+			party.arrivalTime = i;
+			concurrentPartyArrival(worker->dispatcher, &party);
+		}
+		else if(concurrentTaxiArrival(worker->dispatcher, &party))
+		{
+			worker->picked[i] = party.rank;
+			++worker->pickups;
+			if(party.arrivalTime < lastArrival[party.rank]) /* Out of order within a rank */
+			{
+				++worker->fifoViolations;
+			}
+			lastArrival[party.rank] = party.arrivalTime;
+		}
+		else
+		{
+			worker->picked[i] = -1;
+		}
+	}
+	return NULL;
+}
+
+int main(int argc, char* argv[])
+{
+	int maxThreads = (argc > 1) ? atoi(argv[1]) : 8;
+	int numEvents = (argc > 2) ? atoi(argv[2]) : 4000000;
+
+	/* Slightly more taxis than parties, ranks skewed towards the low end */
+	int* events = malloc(numEvents * sizeof(int));
+	int* picked = malloc(numEvents * sizeof(int));
+	worker_t* workers = calloc(maxThreads, sizeof(worker_t));
+	if(events == NULL || picked == NULL || workers == NULL)
+	{
+		printf("Failed to allocate benchmark state\n");
+		exit(1);
+	}
+	unsigned int seed = 12345;
+	long numParties = 0;
+	for (int i = 0; i < numEvents; ++i)
+	{
+		seed = seed * 1103515245u + 12345u;
+		unsigned int r = seed >> 16;
+		if(r % 100 < 48)
+		{
+			double u = (r >> 7) / 512.0;
+			events[i] = (int)(u * u * u * BENCH_RANKS);
+			++numParties;
+		}
+		else
+		{
+			events[i] = -1;
+		}
+	}
+
+	printf("Events: %d (%ld parties)\n", numEvents, numParties);
+	for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+	{
+		concurrentdispatcher_t* dispatcher = createConcurrentDispatcher(1 << 16); /* Far deeper than any rank gets in this stream */
+		for (int r = 0; r < BENCH_RANKS; ++r)
+		{
+			reserveRank(dispatcher, r); /* Keep the rank queue allocations out of the timed region */
+		}
+
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int t = 0; t < numThreads; ++t)
+		{
+			workers[t] = (worker_t){ 0, dispatcher, events, picked, numEvents, t, numThreads, 0, 0 };
+			pthread_create(&workers[t].thread, NULL, runWorker, &workers[t]);
+		}
+
+		long pickups = 0;
+		int fifoViolations = 0;
+		for (int t = 0; t < numThreads; ++t)
+		{
+			pthread_join(workers[t].thread, NULL);
+			pickups += workers[t].pickups;
+			fifoViolations += workers[t].fifoViolations;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		double seconds = elapsedSeconds(start, end);
+
+		/* Every party is either picked up or still pending in its rank */
+		long waiting = 0;
+		for (int r = 0; r < NUM_RANKS; ++r)
+		{
+			waiting += atomic_load(&dispatcher->queues[r].pending);
+		}
+		/* With one thread every pick up must also have come from the highest waiting rank */
+		int consistent = (pickups + waiting == numParties) &&
+			(numThreads > 1 || (fifoViolations == 0 && countRankViolations(events, picked, numEvents) == 0));
+
+		printf("%2d threads: %ld pick ups in %.3f s (%.2f M pick ups/s)%s\n",
+			numThreads, pickups, seconds, pickups / seconds / 1e6,
+			consistent ? "" : " INCONSISTENT");
+		freeConcurrentDispatcher(dispatcher);
+	}
+
+	free(workers);
+	free(picked);
+	free(events);
+	return 0;
+}
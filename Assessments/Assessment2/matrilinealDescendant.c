@@ -10,211 +10,1019 @@
 #include <string.h>
 #include <stdlib.h>
 
-#define MAX_CHILDREN 10
+#define NAME_LENGTH 21 /* Names are cut to 20 characters */
+#define ARENA_INITIAL_CAPACITY 64
+#define INDEX_INITIAL_SIZE 64 /* Must be a power of two */
+#define NO_NODE -1
+#define TOUR_SEGMENT 64 /* Smallest rebalanced window of the Euler tour, power of two */
+#define TOUR_ROOT_DENSITY 0.5 /* Fullest the whole tour may get before it doubles */
+#define MAX_LIFT_LEVELS 31 /* Jumps of up to 2^30 generations, deeper than any int-indexed tree */
+#define GENERATION_BLOCK 256 /* Most people a generation block holds, a full block splits in two */
+
+#include "../../Common/stringPool.h"
 
 /* --------------- Data structures --------------- */
 
-/* Singly linked list node */
-typedef struct _llnode
+/* Array-based stack of node indices, only grows so it can be reused without allocating */
+typedef struct _arraystack
 {
-	void* data;
-	struct _llnode* nextNode;
-} llnode_t;
+	int* items;
+	int count;
+	int capacity;
+} arraystack_t;
 
-/* Linked List */
-typedef struct _linkedlist
+/* Struct-of-arrays node arena, a person is the same index in every array (Root is 0).
+   Indices stay valid when the arrays grow, sisters are linked in the order they were added. */
+typedef struct _tree
 {
-	llnode_t* head;
-	llnode_t* tail;
-} linkedlist_t;
+	int* nameIds; /* Interned names, see stringpool_t */
+	int* parent; /* NO_NODE for the root */
+	int* firstChild; /* NO_NODE when there are no daughters */
+	int* lastChild; /* Appending a daughter is O(1) */
+	int* nextSibling; /* NO_NODE for the youngest daughter */
+	int* depth; /* Generations below the root */
+	int* entryPos; /* Position of the node's entry token in the Euler tour */
+	int* exitPos; /* Position of the node's exit token, descendants lie in between */
+	int count;
+	int capacity;
+} tree_t;
 
-/* Custom tree node */
-typedef struct _tnode
+/* Name id to node index, NO_NODE for names nobody in the tree has */
+typedef struct _nameindex
 {
-	char name[25];
-	struct _tnode* parent; /* The parent of the node */
-	struct _tnode* children; /* Pointer to an array of children */
-	int numChildren;
-	int maxChildren; 
-} tnode_t;
+	int* nodes;
+	int capacity;
+} nameindex_t;
+
+/* Euler tour of the tree kept in a packed-memory array: the entry (2 * node) and exit
+   (2 * node + 1) tokens of every person in Depth-First order, with gaps (NO_NODE) spread
+   out so that a new daughter only shifts a small window of tokens. A gapless post-order
+   array would move every later token (and renumber its node) on each Add, since a daughter
+   goes inside her mother's interval, not at the end; a subtree is still one range to scan. */
+typedef struct _eulertour
+{
+	int* tokens;
+	int* scratch; /* Tokens of the window being rebalanced */
+	int count; /* Tokens in use */
+	int capacity; /* Power of two, at least TOUR_SEGMENT */
+} eulertour_t;
+
+/* Binary lifting table, jumps[k][node] is the ancestor 2^k generations up (NO_NODE past the root).
+   Level 0 is tree.parent, higher levels are only added once the tree is deep enough to use them. */
+typedef struct _lifttable
+{
+	int* jumps[MAX_LIFT_LEVELS];
+	int levels; /* Levels in use, including tree.parent */
+	int capacity; /* Nodes every level above 0 can hold */
+} lifttable_t;
+
+/* Everyone in one generation in Depth-First entry order (Increasing entryPos), split into
+   blocks so that a new daughter only shifts the rest of a single block. */
+typedef struct _generation
+{
+	int** blocks;
+	int* blockCounts; /* People in each block */
+	int numBlocks;
+	int capacity; /* Blocks the directory can hold */
+} generation_t;
+
+/* Generation index, levels[d] holds everyone d generations below the root */
+typedef struct _generationindex
+{
+	generation_t* levels;
+	int count;
+	int capacity;
+} generationindex_t;
 
 /* --------------- Global variables --------------- */
 
-tnode_t treeRoot = { "", NULL, NULL, 0, MAX_CHILDREN };
+tree_t tree = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, 0, 0 };
+nameindex_t nameIndex = { NULL, 0 }; /* Every person in the tree by name */
+eulertour_t tour = { NULL, NULL, 0, 0 };
+int deepestNode = NO_NODE; /* Deepest person, the first in Depth-First order on ties */
+arraystack_t chainStack = { NULL, 0, 0 }; /* Reused by every chain query */
+arraystack_t traversalStack = { NULL, 0, 0 }; /* Reused by every Depth-First traversal */
+lifttable_t lift = { { NULL }, 1, 0 };
+generationindex_t generationIndex = { NULL, 0, 0 };
 
-/* --------------- Linked list-based stack implementation --------------- */
+/* --------------- Array-based stack implementation --------------- */
 
 /* 
-push: Add data (of any type) to the top of the stack.
-@param _data: Pointer to data (of any type) to be stored
+push: Add a node index to the top of the stack, doubling the array when full.
+@param _node: Index of the node to be stored
 @param _stack: Pointer to the stack
 */
-void push(void* _data, linkedlist_t* _stack)
+void push(int _node, arraystack_t* _stack)
 {
-	llnode_t* newNode = calloc(1, sizeof(llnode_t));
-	if(newNode == NULL)
+	if(_stack->count == _stack->capacity)
 	{
-		printf("Failed to allocate new node\n");
-		exit(1);
+		int newCapacity = (_stack->capacity == 0) ? ARENA_INITIAL_CAPACITY : _stack->capacity * 2;
+		int* newItems = realloc(_stack->items, newCapacity * sizeof(int));
+		if(newItems == NULL)
+		{
+			printf("Failed to grow stack\n");
+			exit(1);
+		}
+		_stack->items = newItems;
+		_stack->capacity = newCapacity;
 	}
+	_stack->items[_stack->count++] = _node;
+}
 
-	/* Filling node attributes */
-	newNode->data = _data; /* Fill data */
-	newNode->nextNode = _stack->head; /* Next node is the current head */
-	
-	/* Stack is empty */
-	if(_stack->tail == NULL)
-	{
-		_stack->tail = newNode;
-	}
-	_stack->head = newNode; /* Reassigning the head*/
+/* 
+pop: Remove the node index from the top of stack and return it. 
+@param _stack: Pointer to the stack
+@return: Index of the node, NO_NODE if the stack is empty
+*/
+int pop(arraystack_t* _stack)
+{	
+	if(_stack->count == 0) return NO_NODE;
+	return _stack->items[--_stack->count];
 }
 
 /* 
-pop: Remove data (of any type) from the top of stack and return it. 
+top: Return the node index from the top of stack. 
 @param _stack: Pointer to the stack
-@return: Pointer to the allocated data
+@return: Index of the node, NO_NODE if the stack is empty
 */
-void* pop(linkedlist_t* _stack)
+int top(arraystack_t* _stack)
 {	
-	if(_stack->head == NULL) return NULL;
+	if(_stack->count == 0) return NO_NODE;
+	return _stack->items[_stack->count - 1];
+}
+
+/* 
+freeStack: Free the array of a stack.
+@param _stack: Pointer to the stack
+*/
+void freeStack(arraystack_t* _stack)
+{
+	free(_stack->items);
+	_stack->items = NULL;
+	_stack->count = 0;
+	_stack->capacity = 0;
+}
 
-	llnode_t* prevHead = _stack->head;
-	void* item = (_stack->head)->data;
+/* ---------- Name index - One cell per name id ---------- */
 
-	/* Reassign new head */
-	_stack->head = (_stack->head)->nextNode;
-	if(_stack->head == NULL)
+/* 
+reserveIndex: Grows the name index to one cell per name in the string pool.
+*/
+void reserveIndex()
+{
+	if(nameIndex.capacity >= strings.count)
 	{
-		/* If the new head is null, tail must also be null */
-		_stack->tail = NULL;
+		return;
 	}
 
-	/* Free and set old pointer to NULL*/
-	free(prevHead);
-	prevHead = NULL;
+	int capacity = strings.capacity;
+	nameIndex.nodes = growArray(nameIndex.nodes, sizeof(int), capacity);
+	for (int id = nameIndex.capacity; id < capacity; ++id)
+	{
+		nameIndex.nodes[id] = NO_NODE;
+	}
+	nameIndex.capacity = capacity;
+}
 
-	return item; /* Extract pointer to the data */
+/* 
+indexSearch: Search for a person in the name index.
+@param _name: The name to search for
+@return: Index of the matching node (First in Depth-First order), NO_NODE if not found
+*/
+int indexSearch(char* _name)
+{
+	int id = findString(_name);
+	if(id == NO_NODE || id >= nameIndex.capacity)
+	{
+		return NO_NODE;
+	}
+	return nameIndex.nodes[id];
 }
 
 /* 
-top: Return data (of any type) from the top of stack. 
-@param _stack: Pointer to the stack
-@return: Pointer to the allocated data
+indexInsert: Add a node to the name index. If the name is already taken, the index
+	keeps whichever node DFSearch would find first (The earliest entry in the tour).
+@param _node: Index of the node, already in the tour
 */
-void* top(linkedlist_t* _stack)
-{	
-	if(_stack->head == NULL) return NULL;
-	return (_stack->head)->data; /* Extract pointer to the data */
+void indexInsert(int _node)
+{
+	reserveIndex();
+	int id = tree.nameIds[_node];
+	if(nameIndex.nodes[id] == NO_NODE || tree.entryPos[_node] < tree.entryPos[nameIndex.nodes[id]])
+	{
+		nameIndex.nodes[id] = _node;
+	}
 }
 
-/* --------------- Custom array-based Tree implementation --------------- */
+/* --------------- Packed-memory array Euler tour --------------- */
 
 /* 
-insertChild: Add a new child node to the specified parent node in the tree
-@param _parent: Pointer to the parent node
-@param _name: The string to be sotred in the child node
+placeToken: Writes a token into the tour and records its position on the node.
+@param position: The position in the tour
+@param token: The entry or exit token
 */
-void insertChild(tnode_t* _parent, char* _name)
+void placeToken(int position, int token)
 {
-	/* There can be no more than the max amount of children */
-	if(_parent->numChildren == _parent->maxChildren)
+	tour.tokens[position] = token;
+	if(token & 1)
+	{
+		tree.exitPos[token >> 1] = position;
+	}
+	else
+	{
+		tree.entryPos[token >> 1] = position;
+	}
+}
+
+/* 
+spreadTokens: Writes tokens evenly over a window of the tour and records
+	where every entry/exit token landed.
+@param _tokens: The tokens in tour order
+@param numTokens: The number of tokens
+@param start: First position of the window
+@param size: The number of positions in the window
+*/
+void spreadTokens(int* _tokens, int numTokens, int start, int size)
+{
+	for (int i = start; i < start + size; ++i)
+	{
+		tour.tokens[i] = NO_NODE;
+	}
+	for (int i = 0; i < numTokens; ++i)
+	{
+		placeToken(start + (int)((long)i * size / numTokens), _tokens[i]);
+	}
+}
+
+/* 
+gatherTokens: Copies the tokens of a window into the scratch buffer, splicing the
+	entry and exit tokens of a new node in right before a given position.
+@param start: First position of the window
+@param size: The number of positions in the window
+@param position: The position the new tokens go before
+@param _node: Index of the new node
+@return: The number of gathered tokens
+*/
+int gatherTokens(int start, int size, int position, int _node)
+{
+	int numTokens = 0;
+	for (int i = start; i < start + size; ++i)
+	{
+		if(i == position)
+		{
+			tour.scratch[numTokens++] = 2 * _node;
+			tour.scratch[numTokens++] = 2 * _node + 1;
+		}
+		if(tour.tokens[i] != NO_NODE)
+		{
+			tour.scratch[numTokens++] = tour.tokens[i];
+		}
+	}
+	return numTokens;
+}
+
+/* 
+growTour: Doubles the tour (or creates it) and spreads every token plus a new node over it.
+@param position: The position the new tokens go before, NO_NODE to append
+@param _node: Index of the new node
+*/
+void growTour(int position, int _node)
+{
+	int newCapacity = (tour.capacity == 0) ? TOUR_SEGMENT : tour.capacity * 2;
+	int* newScratch = realloc(tour.scratch, newCapacity * sizeof(int));
+	if(newScratch == NULL)
+	{
+		printf("Failed to allocate Euler tour\n");
+		exit(1);
+	}
+	tour.scratch = newScratch;
+
+	int numTokens = gatherTokens(0, tour.capacity, position, _node);
+	if(position == NO_NODE)
+	{
+		tour.scratch[numTokens++] = 2 * _node;
+		tour.scratch[numTokens++] = 2 * _node + 1;
+	}
+
+	int* newTokens = realloc(tour.tokens, newCapacity * sizeof(int));
+	if(newTokens == NULL)
+	{
+		printf("Failed to allocate Euler tour\n");
+		exit(1);
+	}
+	tour.tokens = newTokens;
+	tour.capacity = newCapacity;
+	spreadTokens(tour.scratch, numTokens, 0, newCapacity);
+	tour.count = numTokens;
+}
+
+/* 
+shiftInsert: Adds the entry and exit tokens of a new node right before a position by
+	shifting the following tokens of the segment into its next two gaps. Only the
+	shifted tokens move, so most daughters touch a handful of positions.
+@param position: The position the new tokens go before
+@param _node: Index of the new node
+@return: 1 if the segment had two gaps after the position, 0 if nothing was changed
+*/
+int shiftInsert(int position, int _node)
+{
+	int end = (position | (TOUR_SEGMENT - 1)) + 1;
+	int gaps = 0;
+	int last = position;
+	while(last < end && gaps < 2)
+	{
+		gaps += (tour.tokens[last++] == NO_NODE);
+	}
+	if(gaps < 2)
+	{
+		return 0;
+	}
+
+	/* Tokens waiting for a slot, in order (Never more than three) */
+	int pending[3] = { 2 * _node, 2 * _node + 1 };
+	int head = 0;
+	int numPending = 2;
+	for (int i = position; i < last; ++i)
+	{
+		if(tour.tokens[i] != NO_NODE)
+		{
+			pending[(head + numPending++) % 3] = tour.tokens[i];
+		}
+		placeToken(i, pending[head]);
+		head = (head + 1) % 3;
+		--numPending;
+	}
+	tour.count += 2;
+	return 1;
+}
+
+/* 
+tourInsertBefore: Adds the entry and exit tokens of a new node right before a
+	position of the tour. Rebalances the smallest enclosing window that stays
+	under its density bound (Looser for small windows, TOUR_ROOT_DENSITY for the
+	whole tour), doubling the tour when even the whole tour is too full.
+@param position: The position the new tokens go before
+@param _node: Index of the new node
+*/
+void tourInsertBefore(int position, int _node)
+{
+	if(shiftInsert(position, _node))
 	{
-		printf("Cannot add more children to the current parent node\n");
 		return;
 	}
 
-	/* If the parent is pointing to no children (NULL), create a new array of children */
-	if(_parent->children == NULL)
+	int height = 0; /* Levels of windows above a segment */
+	while((TOUR_SEGMENT << height) < tour.capacity)
 	{
-		/* Number of children will follow the max amount children from root */
-		tnode_t* _children = calloc(_parent->maxChildren, sizeof(tnode_t));
-		if(_children == NULL)
+		++height;
+	}
+
+	int size = TOUR_SEGMENT;
+	int start = position & ~(size - 1);
+	int used = 0;
+	for (int i = start; i < start + size; ++i)
+	{
+		used += (tour.tokens[i] != NO_NODE);
+	}
+
+	for (int level = 0; level <= height; ++level)
+	{
+		double maxDensity = (height == 0) ? TOUR_ROOT_DENSITY :
+			1.0 - (1.0 - TOUR_ROOT_DENSITY) * level / height;
+		if(used + 2 <= maxDensity * size)
+		{
+			int numTokens = gatherTokens(start, size, position, _node);
+			spreadTokens(tour.scratch, numTokens, start, size);
+			tour.count += 2;
+			return;
+		}
+		if(level == height) break;
+
+		/* Grow to the enclosing window, counting only the half not seen yet */
+		int sibling = start ^ size;
+		for (int i = sibling; i < sibling + size; ++i)
 		{
-			printf("Failed to allocate new array of tree nodes\n");
+			used += (tour.tokens[i] != NO_NODE);
+		}
+		start &= ~size;
+		size *= 2;
+	}
+	growTour(position, _node);
+}
+
+/* 
+isDescendant: Tells whether a node lies strictly below another in the tree.
+@param _node: Index of the possible descendant
+@param _ancestor: Index of the possible ancestor
+@return: 1 if the node is a descendant of the ancestor, 0 otherwise
+*/
+int isDescendant(int _node, int _ancestor)
+{
+	return tree.entryPos[_ancestor] < tree.entryPos[_node] && tree.exitPos[_node] < tree.exitPos[_ancestor];
+}
+
+/* 
+updateDeepest: Makes a new node the deepest one if it is deeper, or just as deep
+	and earlier in Depth-First order (The node DFDeepest would settle on).
+@param _node: Index of the new node, already in the tour
+*/
+void updateDeepest(int _node)
+{
+	if(deepestNode == NO_NODE || tree.depth[_node] > tree.depth[deepestNode] ||
+		(tree.depth[_node] == tree.depth[deepestNode] && tree.entryPos[_node] < tree.entryPos[deepestNode]))
+	{
+		deepestNode = _node;
+	}
+}
+
+/* --------------- Binary lifting ancestor queries --------------- */
+
+/* 
+jumpUp: Returns the ancestor 2^level generations above a node.
+@param _node: Index of the node
+@param level: The level of the jump (Below lift.levels)
+@return: Index of the ancestor, NO_NODE past the root
+*/
+int jumpUp(int _node, int level)
+{
+	return (level == 0) ? tree.parent[_node] : lift.jumps[level][_node];
+}
+
+/* 
+liftInsert: Fills the jumps of a new node, adding a level to the table (and
+	filling it for every node) when the node is the first 2^levels generations deep.
+@param _node: Index of the new node, its mother already in the table
+*/
+void liftInsert(int _node)
+{
+	/* Keep every level as large as the arena */
+	if(lift.capacity < tree.capacity)
+	{
+		for (int k = 1; k < lift.levels; ++k)
+		{
+			int* newJumps = realloc(lift.jumps[k], tree.capacity * sizeof(int));
+			if(newJumps == NULL)
+			{
+				printf("Failed to grow lifting table\n");
+				exit(1);
+			}
+			lift.jumps[k] = newJumps;
+		}
+		lift.capacity = tree.capacity;
+	}
+
+	for (int k = 1; k < lift.levels; ++k)
+	{
+		int half = jumpUp(_node, k - 1);
+		lift.jumps[k][_node] = (half == NO_NODE) ? NO_NODE : jumpUp(half, k - 1);
+	}
+
+	if(lift.levels < MAX_LIFT_LEVELS && tree.depth[_node] == (1 << lift.levels))
+	{
+		int level = lift.levels;
+		lift.jumps[level] = malloc(lift.capacity * sizeof(int));
+		if(lift.jumps[level] == NULL)
+		{
+			printf("Failed to grow lifting table\n");
 			exit(1);
 		}
-		_parent->children = _children; /* Reassign children pointer */
+		++lift.levels;
+
+		/* The level below is complete, so nodes can be filled in any order */
+		for (int node = 0; node < tree.count; ++node)
+		{
+			int half = jumpUp(node, level - 1);
+			lift.jumps[level][node] = (half == NO_NODE) ? NO_NODE : jumpUp(half, level - 1);
+		}
+	}
+}
+
+/* 
+freeLift: Free every level of the lifting table above tree.parent.
+*/
+void freeLift()
+{
+	for (int k = 1; k < lift.levels; ++k)
+	{
+		free(lift.jumps[k]);
+		lift.jumps[k] = NULL;
+	}
+	lift.levels = 1;
+	lift.capacity = 0;
+}
+
+/* 
+ancestorAt: Returns the ancestor a given number of generations above a node.
+@param _node: Index of the node
+@param generations: How far up to go (0 is the node itself)
+@return: Index of the ancestor, NO_NODE if the node is not that deep
+*/
+int ancestorAt(int _node, int generations)
+{
+	if(generations < 0 || generations > tree.depth[_node])
+	{
+		return NO_NODE;
+	}
+
+	/* Take one jump per set bit, every bit fits since the depth does */
+	for (int k = 0; generations != 0; ++k, generations >>= 1)
+	{
+		if(generations & 1)
+		{
+			_node = jumpUp(_node, k);
+		}
+	}
+	return _node;
+}
+
+/* 
+lowestCommonAncestor: Returns the nearest person both nodes descend from (Or are).
+	Climbs the first node while the jump still lands outside the second node's
+	ancestors, checking ancestry with the Euler tour intervals.
+@param _first: Index of the first node
+@param _second: Index of the second node
+@return: Index of the lowest common ancestor
+*/
+int lowestCommonAncestor(int _first, int _second)
+{
+	if(_first == _second || isDescendant(_second, _first))
+	{
+		return _first;
+	}
+	if(isDescendant(_first, _second))
+	{
+		return _second;
+	}
+
+	for (int k = lift.levels - 1; k >= 0; --k)
+	{
+		int up = jumpUp(_first, k);
+		if(up != NO_NODE && up != _second && !isDescendant(_second, up))
+		{
+			_first = up;
+		}
+	}
+	return tree.parent[_first];
+}
+
+/* --------------- Generation index --------------- */
+
+/* 
+generationLowerBound: Finds the first person of a generation whose entry token is at
+	or after a tour position (Binary search on the blocks, then within the block).
+@param _level: Pointer to the generation
+@param position: The tour position
+@param block: Set to the block of the person, numBlocks if there is none
+@param index: Set to the index of the person in the block
+*/
+void generationLowerBound(generation_t* _level, int position, int* block, int* index)
+{
+	/* First block whose last person is at or after the position */
+	int low = 0;
+	int high = _level->numBlocks;
+	while(low < high)
+	{
+		int mid = (low + high) / 2;
+		int last = _level->blocks[mid][_level->blockCounts[mid] - 1];
+		if(tree.entryPos[last] < position) low = mid + 1;
+		else high = mid;
+	}
+	*block = low;
+	*index = 0;
+	if(low == _level->numBlocks) return;
+
+	int* nodes = _level->blocks[low];
+	high = _level->blockCounts[low];
+	while(*index < high)
+	{
+		int mid = (*index + high) / 2;
+		if(tree.entryPos[nodes[mid]] < position) *index = mid + 1;
+		else high = mid;
+	}
+}
+
+/* 
+newGenerationBlock: Adds an empty block to a generation.
+@param _level: Pointer to the generation
+@param block: Where the block goes in the directory
+*/
+void newGenerationBlock(generation_t* _level, int block)
+{
+	if(_level->numBlocks == _level->capacity)
+	{
+		_level->capacity = (_level->capacity == 0) ? 4 : _level->capacity * 2;
+		_level->blocks = growArray(_level->blocks, sizeof(int*), _level->capacity);
+		_level->blockCounts = growArray(_level->blockCounts, sizeof(int), _level->capacity);
+	}
+	int moved = _level->numBlocks - block;
+	memmove(&_level->blocks[block + 1], &_level->blocks[block], moved * sizeof(int*));
+	memmove(&_level->blockCounts[block + 1], &_level->blockCounts[block], moved * sizeof(int));
+	_level->blocks[block] = malloc(GENERATION_BLOCK * sizeof(int));
+	if(_level->blocks[block] == NULL)
+	{
+		printf("Failed to grow generation index\n");
+		exit(1);
+	}
+	_level->blockCounts[block] = 0;
+	++_level->numBlocks;
+}
+
+/* 
+generationInsert: Adds a new node to the index of its generation, in entry order.
+@param _node: Index of the node, already in the tour
+*/
+void generationInsert(int _node)
+{
+	int depth = tree.depth[_node];
+	if(depth >= generationIndex.capacity)
+	{
+		int capacity = (generationIndex.capacity == 0) ? ARENA_INITIAL_CAPACITY : generationIndex.capacity * 2;
+		generationIndex.levels = growArray(generationIndex.levels, sizeof(generation_t), capacity);
+		memset(&generationIndex.levels[generationIndex.capacity], 0, (capacity - generationIndex.capacity) * sizeof(generation_t));
+		generationIndex.capacity = capacity;
+	}
+	if(depth >= generationIndex.count)
+	{
+		generationIndex.count = depth + 1;
+	}
+
+	generation_t* level = &generationIndex.levels[depth];
+	int block = 0;
+	int index = 0;
+	if(level->numBlocks == 0)
+	{
+		newGenerationBlock(level, 0); /* First of the generation */
+	}
+	else
+	{
+		generationLowerBound(level, tree.entryPos[_node], &block, &index);
+		if(block == level->numBlocks) /* After everyone, append to the last block */
+		{
+			block = level->numBlocks - 1;
+			index = level->blockCounts[block];
+		}
+	}
+
+	/* Split a full block, keeping the insertion point in whichever half it fell */
+	if(level->blockCounts[block] == GENERATION_BLOCK)
+	{
+		int half = GENERATION_BLOCK / 2;
+		newGenerationBlock(level, block + 1);
+		memcpy(level->blocks[block + 1], level->blocks[block] + half, (GENERATION_BLOCK - half) * sizeof(int));
+		level->blockCounts[block + 1] = GENERATION_BLOCK - half;
+		level->blockCounts[block] = half;
+		if(index > half)
+		{
+			++block;
+			index -= half;
+		}
+	}
+
+	int* nodes = level->blocks[block];
+	memmove(&nodes[index + 1], &nodes[index], (level->blockCounts[block] - index) * sizeof(int));
+	nodes[index] = _node;
+	++level->blockCounts[block];
+}
+
+/* 
+freeGenerations: Free every block of the generation index.
+*/
+void freeGenerations()
+{
+	for (int d = 0; d < generationIndex.capacity; ++d)
+	{
+		generation_t* level = &generationIndex.levels[d];
+		for (int b = 0; b < level->numBlocks; ++b)
+		{
+			free(level->blocks[b]);
+		}
+		free(level->blocks);
+		free(level->blockCounts);
+	}
+	free(generationIndex.levels);
+	memset(&generationIndex, 0, sizeof(generationindex_t));
+}
+
+/* --------------- Struct-of-arrays Tree implementation --------------- */
+
+/* 
+newNode: Appends a person without relations to the arena, growing it when full.
+@param _nameId: The interned name to be stored in the node
+@return: Index of the new node
+*/
+int newNode(int _nameId)
+{
+	if(tree.count == tree.capacity)
+	{
+		tree.capacity = (tree.capacity == 0) ? ARENA_INITIAL_CAPACITY : tree.capacity * 2;
+		tree.nameIds = growArray(tree.nameIds, sizeof(int), tree.capacity);
+		tree.parent = growArray(tree.parent, sizeof(int), tree.capacity);
+		tree.firstChild = growArray(tree.firstChild, sizeof(int), tree.capacity);
+		tree.lastChild = growArray(tree.lastChild, sizeof(int), tree.capacity);
+		tree.nextSibling = growArray(tree.nextSibling, sizeof(int), tree.capacity);
+		tree.depth = growArray(tree.depth, sizeof(int), tree.capacity);
+		tree.entryPos = growArray(tree.entryPos, sizeof(int), tree.capacity);
+		tree.exitPos = growArray(tree.exitPos, sizeof(int), tree.capacity);
 	}
-	++_parent->numChildren; 
 
-	/* Access the child at the back of the array */
-	tnode_t* _child = &_parent->children[_parent->numChildren - 1];\
-	strncpy(_child->name, _name, 20);
-	_child->parent = _parent;
-	_child->children = NULL; /* New node = no children */
-	_child->numChildren = 0; 
-	_child->maxChildren = _parent->maxChildren; /* Inherit from parent */
+	int node = tree.count++;
+	tree.nameIds[node] = _nameId;
+	tree.parent[node] = NO_NODE;
+	tree.firstChild[node] = NO_NODE;
+	tree.lastChild[node] = NO_NODE;
+	tree.nextSibling[node] = NO_NODE;
+	tree.depth[node] = 0;
+	tree.entryPos[node] = NO_NODE;
+	tree.exitPos[node] = NO_NODE;
+	return node;
+}
+
+/* 
+linkRoot: Adds the root node to the tree and every index.
+@param _nameId: The interned name to be stored in the root
+@return: Index of the root node
+*/
+int linkRoot(int _nameId)
+{
+	int root = newNode(_nameId); /* Root is node 0 */
+	growTour(NO_NODE, root);
+	indexInsert(root);
+	generationInsert(root);
+	updateDeepest(root);
+	return root;
+}
+
+/* 
+linkChild: Add a new child node to the specified parent node in the tree and every index.
+@param _parent: Index of the parent node
+@param _nameId: The interned name to be stored in the child node
+@return: Index of the child node
+*/
+int linkChild(int _parent, int _nameId)
+{
+	int _child = newNode(_nameId);
+	tree.parent[_child] = _parent;
+	tree.depth[_child] = tree.depth[_parent] + 1;
+	liftInsert(_child);
+
+	/* Link the child after the youngest sister */
+	if(tree.lastChild[_parent] == NO_NODE)
+	{
+		tree.firstChild[_parent] = _child;
+	}
+	else
+	{
+		tree.nextSibling[tree.lastChild[_parent]] = _child;
+	}
+	tree.lastChild[_parent] = _child;
+
+	/* The daughter's tour follows every earlier descendant of her mother */
+	tourInsertBefore(tree.exitPos[_parent], _child);
+	indexInsert(_child);
+	generationInsert(_child);
+	updateDeepest(_child);
+	return _child;
+}
+
+/* 
+insertChild: Add a new child node to the specified parent node in the tree
+@param _parent: Index of the parent node
+@param _name: The string to be sotred in the child node
+@return: Index of the child node
+*/
+int insertChild(int _parent, char* _name)
+{
+	return linkChild(_parent, internString(_name));
 }
 
 /* 
 DFSearch: Search for the node name in every node in the tree/subtree using Depth-First Traversal
-@param _root: Pointer to the root node of the tree/subtree
+	(Pre-order, iterative). The stack holds the next node to visit on every level of the
+	current path, so it never grows past the depth of the tree.
+@param _root: Index of the root node of the tree/subtree
 @param _name: The name to search for in the tree/subtree
-@return: Pointer to the first matching node (Leftest node in the tree)
+@return: Index of the first matching node (Leftest node in the tree), NO_NODE if not found
 */
-tnode_t* DFSearch(tnode_t* _root, char* _name)
+int DFSearch(int _root, char* _name)
 {
-	/* Non-existent node */
-	if(_root == NULL) return NULL; 
+	/* Non-existent node, or a name nobody was ever given */
+	int nameId = findString(_name);
+	if(_root == NO_NODE || nameId == NO_NODE) return NO_NODE; 
 
-	/* If node name matches, return it and stop exploration. */
-	if(!strcmp(_root->name, _name)) 
+	traversalStack.count = 0;
+	push(_root, &traversalStack);
+	while(traversalStack.count > 0)
 	{
-		return _root;
-	} 
+		int node = pop(&traversalStack);
 
-	/* Exits loop if unable to explore deeper than the depth of all child nodes */
-	for (int i = 0; i < _root->numChildren; ++i)
-	{
-		tnode_t* searchedNode = DFSearch(&_root->children[i], _name);
-		if(searchedNode != NULL)
+		/* If node name matches, return it and stop exploration. */
+		if(tree.nameIds[node] == nameId) 
+		{
+			return node;
+		} 
+
+		/* The younger sister waits below the daughters (Not past the subtree root) */
+		if(node != _root && tree.nextSibling[node] != NO_NODE)
+		{
+			push(tree.nextSibling[node], &traversalStack);
+		}
+		if(tree.firstChild[node] != NO_NODE)
 		{
-			return searchedNode;
+			push(tree.firstChild[node], &traversalStack);
 		}
 	}
 
 	/* No matching node found */
-	return NULL;
+	return NO_NODE;
+}
+
+/* 
+pushLeftmostPath: Pushes a node and its chain of eldest daughters, down to a leaf.
+@param _node: Index of the first node of the path
+@param _stack: Pointer to the stack
+*/
+void pushLeftmostPath(int _node, arraystack_t* _stack)
+{
+	for (; _node != NO_NODE; _node = tree.firstChild[_node])
+	{
+		push(_node, _stack);
+	}
 }
 
 /* 
 DFPrint: Print the string of every node in the tree/subtree using Depth-First Traversal
-@param _root: Pointer to the root node of the tree/subtree
+	(Post-order, iterative). The stack holds the current path from the subtree root.
+@param _root: Index of the root node of the tree/subtree
 */
-void DFPrint(tnode_t* _root)
+void DFPrint(int _root)
 {
 	/* Non-existent node */
-	if(_root == NULL) return;
+	if(_root == NO_NODE) return;
 
-	/* Exits loop if unable to explore deeper than the depth of all child nodes */
-	for (int i = 0; i < _root->numChildren; ++i)
+	traversalStack.count = 0;
+	pushLeftmostPath(_root, &traversalStack);
+	while(traversalStack.count > 0)
 	{
-		DFPrint(&_root->children[i]);
+		/* Every daughter of the node on top is printed, so print it (Post-order) */
+		int node = pop(&traversalStack);
+		printf("%s ", stringOf(tree.nameIds[node]));
+
+		/* Continue with the younger sister's subtree, if any, before the mother */
+		if(node != _root)
+		{
+			pushLeftmostPath(tree.nextSibling[node], &traversalStack);
+		}
 	}
+}
 
-	/* Print the string contained in the node (Post-order) */
-	printf("%s ", _root->name);
+/* 
+freeTree: Free every array of the node arena.
+*/
+void freeTree()
+{
+	free(tree.nameIds);
+	free(tree.parent);
+	free(tree.firstChild);
+	free(tree.lastChild);
+	free(tree.nextSibling);
+	free(tree.depth);
+	free(tree.entryPos);
+	free(tree.exitPos);
+	memset(&tree, 0, sizeof(tree_t));
+
+	free(tour.tokens);
+	free(tour.scratch);
+	memset(&tour, 0, sizeof(eulertour_t));
+	free(nameIndex.nodes);
+	memset(&nameIndex, 0, sizeof(nameindex_t));
+	freeStrings();
+	deepestNode = NO_NODE;
+	freeStack(&chainStack);
+	freeStack(&traversalStack);
+	freeLift();
+	freeGenerations();
 }
 
+/* --------------- Bulk out-of-order loader --------------- */
+
 /* 
-freeTree: Free all of the nodes from the tree/subtree using Depth-First Traversal (Recursion)
-@param _root: Pointer to the root node of the tree/subtree
+bulkLoad: Reads a whole lineage, the root followed by (name, mother) records in any
+	order, and builds the tree in a few linear passes instead of one search per record.
+	A mother's name refers to the first record with that name, sisters keep their file
+	order. Records that never connect to the root are counted as unsuccessful.
+@param numRecords: The number of records, the root included
 */
-void freeTree(tnode_t* _root)
+void bulkLoad(int numRecords)
 {
-	/* Non-existent node */
-	if(_root == NULL) return;
+	if(numRecords < 1) /* The root at least */
+	{
+		printf("Invalid number of records\n");
+		exit(1);
+	}
+
+	char name[25];
+	char motherName[25];
+	int* recordName = malloc(numRecords * sizeof(int));
+	int* recordMother = malloc(numRecords * sizeof(int)); /* Name id, then record index */
+	int* childStart = calloc(numRecords + 2, sizeof(int)); /* Daughters of record r are children[childStart[r], childStart[r + 1]) */
+	int* children = malloc(numRecords * sizeof(int));
+	if(recordName == NULL || recordMother == NULL || childStart == NULL || children == NULL)
+	{
+		printf("Failed to allocate bulk loader\n");
+		exit(1);
+	}
+
+	/* Size the tables for every record up front, so they never rehash */
+	int indexSize = INDEX_INITIAL_SIZE;
+	while(indexSize < 2 * numRecords)
+	{
+		indexSize *= 2;
+	}
+	resizeStrings(indexSize);
+
+	/* Pass 1: intern every name */
+	readName(name);
+	recordName[0] = internString(name);
+	recordMother[0] = NO_NODE;
+	for (int r = 1; r < numRecords; ++r)
+	{
+		readName(name);
+		readName(motherName);
+		recordName[r] = internString(name);
+		recordMother[r] = internString(motherName);
+	}
 
-	/* Exits loop if unable to explore deeper than the depth of all child nodes */
-	for (int i = 0; i < _root->numChildren; ++i)
+	/* First record named after each string, NO_NODE if only seen as a mother */
+	int* firstRecord = malloc(strings.count * sizeof(int));
+	if(firstRecord == NULL)
 	{
-		freeTree(&_root->children[i]);
+		printf("Failed to allocate bulk loader\n");
+		exit(1);
+	}
+	for (int id = 0; id < strings.count; ++id)
+	{
+		firstRecord[id] = NO_NODE;
+	}
+	for (int r = numRecords - 1; r >= 0; --r)
+	{
+		firstRecord[recordName[r]] = r;
 	}
 
-	/* Free the pointer to the array of children of the current subtree */
-	free(_root->children);
-	_root->children = NULL;
+	/* Pass 2: resolve mothers and count daughters, shifted by two so that the
+	   prefix sums leave room for the write cursors of pass 3 */
+	for (int r = 1; r < numRecords; ++r)
+	{
+		recordMother[r] = firstRecord[recordMother[r]];
+		if(recordMother[r] != NO_NODE)
+		{
+			++childStart[recordMother[r] + 2];
+		}
+	}
+	for (int r = 2; r <= numRecords; ++r)
+	{
+		childStart[r] += childStart[r - 1];
+	}
+
+	/* Pass 3: stable counting sort of the records by mother (Compressed children layout).
+	   childStart[m + 1] is the write cursor of mother m and ends at the start of m + 1 */
+	for (int r = 1; r < numRecords; ++r)
+	{
+		if(recordMother[r] != NO_NODE)
+		{
+			children[childStart[recordMother[r] + 1]++] = r;
+		}
+	}
+
+	/* Pass 4: Breadth-First from the root, so every mother is linked before her
+	   daughters. Node indices are handed out in visiting order, the record at queue
+	   position i becomes node i. The tour, lifting, generation and name indexes are
+	   kept by linkChild as for any Add, without searching for the mother. */
+	int* queue = recordMother; /* Mothers are resolved, reuse the array */
+	queue[0] = 0;
+	int tail = 1;
+	linkRoot(recordName[0]);
+	for (int head = 0; head < tail; ++head)
+	{
+		int record = queue[head];
+		for (int k = childStart[record]; k < childStart[record + 1]; ++k)
+		{
+			int child = children[k];
+			queue[tail++] = child;
+			linkChild(head, recordName[child]);
+		}
+	}
+
+	printf("Added %d\n", tail);
+	if(tail < numRecords)
+	{
+		printf("Unsuccessful %d\n", numRecords - tail);
+	}
+
+	free(firstRecord);
+	free(recordName);
+	free(recordMother);
+	free(childStart);
+	free(children);
 }
 
 /* --------------- Mother-daughter tree helper functions ---- ----------- */
@@ -226,7 +1034,7 @@ addRoot: Adds person with a given name at the root.
 void addRoot(char* name)
 {
 	printf("Added\n");
-	strncpy(treeRoot.name, name, 20);
+	linkRoot(internString(name));
 }
 
 
@@ -236,8 +1044,8 @@ addNonRoot: Adds person with a given name and mother's name to the tree.
 */
 void addNonRoot(char* name, char* motherName)
 {
-	tnode_t* motherNode = DFSearch(&treeRoot, motherName);
-	if(motherNode == NULL)
+	int motherNode = indexSearch(motherName);
+	if(motherNode == NO_NODE)
 	{
 		printf("Unsuccessful\n");
 		return;
@@ -252,43 +1060,169 @@ queryDescendant: Prints every daughter's name of the queried mother node.
 */
 void queryDescendant(char* name)
 {
-	tnode_t* motherNode = DFSearch(&treeRoot, name);
-	if(motherNode == NULL || motherNode->numChildren == 0)
+	int motherNode = indexSearch(name);
+	if(motherNode == NO_NODE || tree.firstChild[motherNode] == NO_NODE)
+	{
+		printf("Not Found\n");
+		return;
+	}
+
+	/* Descendants are the tokens between the mother's own two, exit tokens come in post-order */
+	for (int i = tree.entryPos[motherNode] + 1; i < tree.exitPos[motherNode]; ++i)
+	{
+		int token = tour.tokens[i];
+		if(token != NO_NODE && (token & 1))
+		{
+			printf("%s ", stringOf(tree.nameIds[token >> 1]));
+		}
+	}
+	printf("\n");
+}
+
+/* 
+queryIsDescendant: Prints whether a person is a descendant of another.
+@param name: The name of the possible descendant
+@param ancestorName: The name of the possible ancestor
+*/
+void queryIsDescendant(char* name, char* ancestorName)
+{
+	int node = indexSearch(name);
+	int ancestorNode = indexSearch(ancestorName);
+	if(node == NO_NODE || ancestorNode == NO_NODE)
+	{
+		printf("Not Found\n");
+		return;
+	}
+	printf(isDescendant(node, ancestorNode) ? "Yes\n" : "No\n");
+}
+
+/* 
+queryMatriarch: Prints the nearest common matriarch of two people.
+@param name: The name of the first person
+@param otherName: The name of the second person
+*/
+void queryMatriarch(char* name, char* otherName)
+{
+	int node = indexSearch(name);
+	int otherNode = indexSearch(otherName);
+	if(node == NO_NODE || otherNode == NO_NODE)
+	{
+		printf("Not Found\n");
+		return;
+	}
+	printf("%s\n", stringOf(tree.nameIds[lowestCommonAncestor(node, otherNode)]));
+}
+
+/* 
+queryAncestor: Prints the ancestor a given number of generations above a person.
+@param name: The name of the person
+@param generations: How far up to go (0 is the person herself)
+*/
+void queryAncestor(char* name, int generations)
+{
+	int node = indexSearch(name);
+	int ancestorNode = (node == NO_NODE) ? NO_NODE : ancestorAt(node, generations);
+	if(ancestorNode == NO_NODE)
+	{
+		printf("Not Found\n");
+		return;
+	}
+	printf("%s\n", stringOf(tree.nameIds[ancestorNode]));
+}
+
+/* 
+queryGeneration: Prints everyone a given number of generations below a person, in
+	Depth-First order. They are the people of that generation whose entry token lies
+	between the person's own two, a contiguous run of the generation index.
+@param name: The name of the person
+@param generations: How far down to go (0 is the person herself)
+*/
+void queryGeneration(char* name, int generations)
+{
+	int node = indexSearch(name);
+	/* Compared before adding, a huge number of generations would overflow the depth */
+	if(node == NO_NODE || generations < 0 || generations > generationIndex.count - 1 - tree.depth[node])
 	{
 		printf("Not Found\n");
 		return;
 	}
+	int depth = tree.depth[node] + generations;
 
-	/* DFPrint prints the inputted node too, so we loop through the chlidren instead */
-	for (int i = 0; i < motherNode->numChildren; ++i)
+	generation_t* level = &generationIndex.levels[depth];
+	int block, index, endBlock, endIndex;
+	generationLowerBound(level, tree.entryPos[node], &block, &index);
+	generationLowerBound(level, tree.exitPos[node], &endBlock, &endIndex);
+	if(block == endBlock && index == endIndex)
 	{
-		DFPrint(&motherNode->children[i]);
+		printf("Not Found\n");
+		return;
+	}
+
+	while(block < endBlock || (block == endBlock && index < endIndex))
+	{
+		if(index == level->blockCounts[block])
+		{
+			++block;
+			index = 0;
+			continue;
+		}
+		printf("%s ", stringOf(tree.nameIds[level->blocks[block][index++]]));
 	}
 	printf("\n");
 }
 
+/* 
+queryApart: Prints how many generations apart two people are (Steps through their matriarch).
+@param name: The name of the first person
+@param otherName: The name of the second person
+*/
+void queryApart(char* name, char* otherName)
+{
+	int node = indexSearch(name);
+	int otherNode = indexSearch(otherName);
+	if(node == NO_NODE || otherNode == NO_NODE)
+	{
+		printf("Not Found\n");
+		return;
+	}
+	int matriarch = lowestCommonAncestor(node, otherNode);
+	printf("%d\n", tree.depth[node] + tree.depth[otherNode] - 2 * tree.depth[matriarch]);
+}
+
 /* 
 DFDeepest: Search for the deepest node name in the tree/subtree using Depth-First Traversal
-@param node: Pointer to the root node of the tree/subtree
-@param depth: The current explored depth
+	(Pre-order, iterative, same stack discipline as DFSearch)
+@param node: Index of the root node of the tree/subtree
+@param depth: The depth of the root node
 @param maxDepth: The maximum depth explored within the tree/subtree
-@param deepestNode: The pointer to the pointer to the deepest node (Node pointer updated constantly)
+@param deepestNode: Pointer to the index of the deepest node (Updated constantly)
 */
-void DFDeepest(tnode_t* node, int depth, int* maxDepth, tnode_t** deepestNode)
+void DFDeepest(int node, int depth, int* maxDepth, int* deepestNode)
 {
 	/* Non-existent node */
-	if(node == NULL) return;
+	if(node == NO_NODE) return;
 
-	if(depth > *maxDepth)
+	int root = node;
+	traversalStack.count = 0;
+	push(root, &traversalStack);
+	while(traversalStack.count > 0)
 	{
-		*maxDepth = depth;
-		*deepestNode = node;
-	}
+		node = pop(&traversalStack);
+		int nodeDepth = depth + tree.depth[node] - tree.depth[root];
+		if(nodeDepth > *maxDepth)
+		{
+			*maxDepth = nodeDepth;
+			*deepestNode = node;
+		}
 
-	/* Exits loop if unable to explore deeper than the depth of all child nodes */
-	for (int i = 0; i < node->numChildren; ++i)
-	{
-		DFDeepest(&node->children[i], depth + 1, maxDepth, deepestNode);
+		if(node != root && tree.nextSibling[node] != NO_NODE)
+		{
+			push(tree.nextSibling[node], &traversalStack);
+		}
+		if(tree.firstChild[node] != NO_NODE)
+		{
+			push(tree.firstChild[node], &traversalStack);
+		}
 	}
 }
 
@@ -296,41 +1230,52 @@ void DFDeepest(tnode_t* node, int depth, int* maxDepth, tnode_t** deepestNode)
 /* queryLongestDescendantChain: Prints the longest descendant chain in the tree from top to bottom. */
 void queryLongestDescendantChain()
 {
-	int maxDepth = -1; /* Ensures that the tree root starts at depth 0*/
-	tnode_t* deepestNode = NULL; /* Pointer to the deepest tree node */
-
-	/* Finds the deepest node in the tree */
-	DFDeepest(&treeRoot, 0, &maxDepth, &deepestNode);
-
-	/* Create a stack of names */
-	linkedlist_t chainStack = { NULL, NULL };
-	
-	/* Climb the chain of descendants until the tree root is reached */
-	while(deepestNode != NULL)
+	/* Climb the chain of descendants from the deepest node until the tree root is reached */
+	for (int node = deepestNode; node != NO_NODE; node = tree.parent[node])
 	{
-		push(&deepestNode->name, &chainStack); /* Push name string into the stack */
-		deepestNode = deepestNode->parent; /* Climb up the chain */
+		push(node, &chainStack);
 	}
 	
 	/* Prints the descendant chain from top to bottom */
-	while(chainStack.head != NULL)
+	while(chainStack.count > 0)
 	{
-		char* name = pop(&chainStack);
-		printf("%s ", name);
+		printf("%s ", stringOf(tree.nameIds[pop(&chainStack)]));
 	}
 	printf("\n");
 }
 
-int main()
+/* queryLongestDescendantLength: Prints the number of people in the longest descendant chain. */
+void queryLongestDescendantLength()
+{
+	printf("%d\n", tree.depth[deepestNode] + 1);
+}
+
+int main(int argc, char* argv[])
 {
+	int bulk = 0; // --bulk: Whole lineage first, in any order
+	for (int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--bulk") == 0) bulk = 1;
+	}
+
 	char input[64]; // Input operation name
 	char name[25]; // The name of the woman
 	char motherName[25]; // The number of woman's mother
-	int numOperations; // The number of operations.
+	int numOperations = 0; // The number of operations (0 if none could be read)
+	int firstOperation = 1; // The root counts as the first operation
 	scanf("%d", &numOperations);
-	scanf("\n%s", name);
-	addRoot(name);
-	for (int i = 1 ; i < numOperations ; i ++)
+	if(bulk)
+	{
+		bulkLoad(numOperations); /* The count was the number of records */
+		scanf("%d", &numOperations);
+		firstOperation = 0;
+	}
+	else
+	{
+		scanf("\n%s", name);
+		addRoot(name);
+	}
+	for (int i = firstOperation ; i < numOperations ; i ++)
 	{
 		scanf("\n%s", input);
 		if (strcmp(input, "Add") == 0)
@@ -343,10 +1288,42 @@ int main()
 			scanf(" %s", name);
 			queryDescendant(name);
 		}
+		else if (strcmp(input, "IsDescendant") == 0)
+		{
+			scanf(" %s %s", name, motherName);
+			queryIsDescendant(name, motherName);
+		}
+		else if (strcmp(input, "Matriarch") == 0)
+		{
+			scanf(" %s %s", name, motherName);
+			queryMatriarch(name, motherName);
+		}
+		else if (strcmp(input, "Ancestor") == 0)
+		{
+			int generations;
+			scanf(" %s %d", name, &generations);
+			queryAncestor(name, generations);
+		}
+		else if (strcmp(input, "Generation") == 0)
+		{
+			int generations;
+			scanf(" %s %d", name, &generations);
+			queryGeneration(name, generations);
+		}
+		else if (strcmp(input, "Apart") == 0)
+		{
+			scanf(" %s %s", name, motherName);
+			queryApart(name, motherName);
+		}
+		else if (strcmp(input, "MaxLength") == 0)
+		{
+			queryLongestDescendantLength();
+		}
 		else
 		{
 			queryLongestDescendantChain();
 		}
 	}	
-	freeTree(&treeRoot); /* Free all nodes from the tree */
+	freeTree(); /* Free all nodes from the tree */
+	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,203 @@
+/*
+	Matrilineal Depth-First Traversal Benchmark
+	Compares the iterative DFSearch, DFPrint and DFDeepest in matrilinealDescendant.c
+	against the original recursive versions on a wide random tree, checking that
+	both visit in the same order. Then walks a single chain far deeper than the
+	recursive versions can handle with the default stack.
+
+	Build: gcc -O2 -o matrilinealDescendantBench matrilinealDescendantBench.c
+	Usage: ./matrilinealDescendantBench [numNodes] [chainLength]
+*/
+
+#define main matrilinealDescendantMain
+#include "matrilinealDescendant.c"
+#undef main
+
+#include <time.h>
+
+/* --------------- Original recursive traversals --------------- */
+
+/*
+recursiveDFSearch: DFSearch as it was before, one call per generation.
+@param _root: Index of the root node of the tree/subtree
+@param _name: The name to search for in the tree/subtree
+@return: Index of the first matching node, NO_NODE if not found
+*/
+int recursiveDFSearch(int _root, char* _name)
+{
+	if(!strcmp(stringOf(tree.nameIds[_root]), _name))
+	{
+		return _root;
+	}
+	for (int child = tree.firstChild[_root]; child != NO_NODE; child = tree.nextSibling[child])
+	{
+		int searchedNode = recursiveDFSearch(child, _name);
+		if(searchedNode != NO_NODE)
+		{
+			return searchedNode;
+		}
+	}
+	return NO_NODE;
+}
+
+/*
+recursiveDFPrint: DFPrint as it was before, one call per generation.
+@param _root: Index of the root node of the tree/subtree
+*/
+void recursiveDFPrint(int _root)
+{
+	for (int child = tree.firstChild[_root]; child != NO_NODE; child = tree.nextSibling[child])
+	{
+		recursiveDFPrint(child);
+	}
+	printf("%s ", stringOf(tree.nameIds[_root]));
+}
+
+/*
+recursiveDFDeepest: DFDeepest as it was before, one call per generation.
+@param node: Index of the root node of the tree/subtree
+@param depth: The current explored depth
+@param maxDepth: The maximum depth explored within the tree/subtree
+@param deepestNode: Pointer to the index of the deepest node
+*/
+void recursiveDFDeepest(int node, int depth, int* maxDepth, int* deepestNode)
+{
+	if(depth > *maxDepth)
+	{
+		*maxDepth = depth;
+		*deepestNode = node;
+	}
+	for (int child = tree.firstChild[node]; child != NO_NODE; child = tree.nextSibling[child])
+	{
+		recursiveDFDeepest(child, depth + 1, maxDepth, deepestNode);
+	}
+}
+
+/* --------------- Benchmark --------------- */
+
+/*
+elapsedSeconds: Returns the seconds elapsed between two timestamps.
+@param start: The earlier timestamp
+@param end: The later timestamp
+@return: Elapsed time in seconds
+*/
+double elapsedSeconds(struct timespec start, struct timespec end)
+{
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/*
+buildTree: Grows a random tree from a fresh arena. Each person's mother is the
+	previous person with probability chainPercent, otherwise one of the most recent 1024.
+@param numNodes: The number of people in the tree
+@param chainPercent: How often a person continues the latest chain
+*/
+void buildTree(int numNodes, int chainPercent)
+{
+	char name[NAME_LENGTH];
+	unsigned int seed = 12345;
+	freeTree();
+	int root = newNode(internString("P0"));
+	growTour(NO_NODE, root);
+	indexInsert(root);
+	updateDeepest(root);
+	for (int i = 1; i < numNodes; ++i)
+	{
+		seed = seed * 1103515245u + 12345u;
+		int window = (i < 1024) ? i : 1024;
+		int mother = ((int)((seed >> 8) % 100) < chainPercent) ? i - 1 : i - 1 - (int)((seed >> 4) % window);
+		sprintf(name, "P%d", i);
+		insertChild(mother, name);
+	}
+}
+
+/*
+capturePrint: Runs a print traversal with stdout sent to a memory buffer.
+@param print: The traversal
+@param _root: Index of the root node
+@param seconds: Set to the time taken
+@return: The printed text (Freed by the caller)
+*/
+char* capturePrint(void (*print)(int), int _root, double* seconds)
+{
+	char* text = NULL;
+	size_t size = 0;
+	FILE* original = stdout;
+	stdout = open_memstream(&text, &size);
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	print(_root);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	*seconds = elapsedSeconds(start, end);
+
+	fclose(stdout);
+	stdout = original;
+	return text;
+}
+
+int main(int argc, char* argv[])
+{
+	int numNodes = (argc > 1) ? atoi(argv[1]) : 2000000;
+	int chainLength = (argc > 2) ? atoi(argv[2]) : 2000000;
+	struct timespec start, end;
+	int consistent = 1;
+
+	/* Wide tree, both versions */
+	buildTree(numNodes, 20);
+	printf("Wide tree: %d nodes, %d generations\n", numNodes, tree.depth[deepestNode] + 1);
+
+	/* The youngest person is the last of their generation, so both walk most of the tree */
+	char lastName[NAME_LENGTH];
+	sprintf(lastName, "P%d", numNodes - 1);
+	double recursiveTime, iterativeTime;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	int recursiveMatch = recursiveDFSearch(0, lastName) + recursiveDFSearch(0, "P1999");
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	recursiveTime = elapsedSeconds(start, end);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	int iterativeMatch = DFSearch(0, lastName) + DFSearch(0, "P1999");
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	iterativeTime = elapsedSeconds(start, end);
+	consistent &= (recursiveMatch == iterativeMatch);
+	printf("DFSearch:  recursive %.3f s, iterative %.3f s\n", recursiveTime, iterativeTime);
+
+	char* recursiveText = capturePrint(recursiveDFPrint, 0, &recursiveTime);
+	char* iterativeText = capturePrint(DFPrint, 0, &iterativeTime);
+	consistent &= !strcmp(recursiveText, iterativeText);
+	printf("DFPrint:   recursive %.3f s, iterative %.3f s\n", recursiveTime, iterativeTime);
+	free(recursiveText);
+	free(iterativeText);
+
+	int recursiveDepth = -1, iterativeDepth = -1;
+	int recursiveNode = NO_NODE, iterativeNode = NO_NODE;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	recursiveDFDeepest(0, 0, &recursiveDepth, &recursiveNode);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	recursiveTime = elapsedSeconds(start, end);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	DFDeepest(0, 0, &iterativeDepth, &iterativeNode);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	iterativeTime = elapsedSeconds(start, end);
+	consistent &= (recursiveNode == iterativeNode && recursiveNode == deepestNode);
+	printf("DFDeepest: recursive %.3f s, iterative %.3f s\n", recursiveTime, iterativeTime);
+
+	/* Single chain, iterative only (The recursive versions overflow the stack long before) */
+	buildTree(chainLength, 100);
+	printf("Chain: %d generations\n", tree.depth[deepestNode] + 1);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	sprintf(lastName, "P%d", chainLength - 1);
+	consistent &= (DFSearch(0, lastName) == chainLength - 1);
+	iterativeDepth = -1;
+	DFDeepest(0, 0, &iterativeDepth, &iterativeNode);
+	consistent &= (iterativeNode == deepestNode);
+	free(capturePrint(DFPrint, 0, &iterativeTime));
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("DFSearch + DFDeepest + DFPrint: %.3f s, stack of %d nodes\n",
+		elapsedSeconds(start, end), traversalStack.capacity);
+
+	printf("Results %s\n", consistent ? "match" : "DIFFER");
+	freeTree();
+	return consistent ? 0 : 1;
+}
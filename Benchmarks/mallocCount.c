@@ -0,0 +1,62 @@
+/*  Allocation Counter
+ *
+ *  Preload library that counts malloc/calloc/realloc calls of a program
+ *  and writes the total to the file named by MALLOC_COUNT_FILE at exit.
+ *  Used by taxiBench.c, the programs themselves are not modified.
+ *
+ *  Build: gcc -O2 -shared -fPIC -o mallocCount.so mallocCount.c
+ *  Usage: MALLOC_COUNT_FILE=allocs.txt LD_PRELOAD=./mallocCount.so ./program
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* glibc's own entry points, so no dlsym bootstrapping is needed */
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+
+/* --------------- Global variables --------------- */
+
+unsigned long long allocationCount = 0;
+
+/* --------------- Allocator wrappers --------------- */
+
+void* malloc(size_t size)
+{
+	__atomic_fetch_add(&allocationCount, 1, __ATOMIC_RELAXED);
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+	__atomic_fetch_add(&allocationCount, 1, __ATOMIC_RELAXED);
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+	__atomic_fetch_add(&allocationCount, 1, __ATOMIC_RELAXED);
+	return __libc_realloc(ptr, size);
+}
+
+/* 
+reportCount: Writes the allocation count once the program exits.
+*/
+__attribute__((destructor)) void reportCount()
+{
+	unsigned long long total = allocationCount; /* Before fopen allocates */
+	char* path = getenv("MALLOC_COUNT_FILE");
+	if(path == NULL)
+	{
+		return;
+	}
+
+	FILE* file = fopen(path, "w");
+	if(file == NULL)
+	{
+		return;
+	}
+	fprintf(file, "%llu\n", total);
+	fclose(file);
+}
@@ -0,0 +1,163 @@
+/*  Taxi Benchmark Driver
+ *
+ *  Runs a taxi program on a workload file and reports events/sec, peak RSS
+ *  and heap allocations (Counted by the mallocCount.so preload library).
+ *
+ *  Build: gcc -O2 -o taxiBench taxiBench.c
+ *         gcc -O2 -shared -fPIC -o mallocCount.so mallocCount.c
+ *  Usage: ./taxiBench <workload.in> <program> [program arguments...]
+ *
+ *  Example:
+ *    ./taxiWorkload airport 10000000 bursty > airport.in
+ *    ./taxiWorkload vip 10000000 skewed > vip.in
+ *    ./taxiBench airport.in ../Labs/Lab1/airportTaxi
+ *    ./taxiBench vip.in ../Assessments/Assessment1/vipTaxi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#define COUNT_FILE_TEMPLATE "/tmp/taxiBenchXXXXXX"
+
+/* 
+elapsedSeconds: Returns the seconds elapsed between two timestamps.
+@param start: The earlier timestamp
+@param end: The later timestamp
+@return: Elapsed time in seconds
+*/
+double elapsedSeconds(struct timespec start, struct timespec end)
+{
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/* 
+preloadPath: Returns the absolute path of mallocCount.so next to this driver.
+@param driverPath: argv[0] of the driver
+@param path: Buffer receiving the path
+@param size: Size of the buffer
+@return: 1 if the library exists, 0 otherwise
+*/
+int preloadPath(char* driverPath, char* path, size_t size)
+{
+	char directory[4096] = ".";
+	char* slash = strrchr(driverPath, '/');
+	if(slash != NULL)
+	{
+		snprintf(directory, sizeof(directory), "%.*s", (int)(slash - driverPath), driverPath);
+	}
+
+	char resolved[4096];
+	if(realpath(directory, resolved) == NULL)
+	{
+		return 0;
+	}
+	snprintf(path, size, "%s/mallocCount.so", resolved);
+	return access(path, R_OK) == 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc < 3)
+	{
+		fprintf(stderr, "Usage: %s <workload.in> <program> [program arguments...]\n", argv[0]);
+		return 1;
+	}
+
+	/* The first line of a workload is its number of events */
+	long numEvents = 0;
+	FILE* workload = fopen(argv[1], "r");
+	if(workload == NULL || fscanf(workload, "%ld", &numEvents) != 1)
+	{
+		fprintf(stderr, "Cannot read workload %s\n", argv[1]);
+		return 1;
+	}
+	fclose(workload);
+
+	char library[4096];
+	int countAllocations = preloadPath(argv[0], library, sizeof(library));
+	char countFile[] = COUNT_FILE_TEMPLATE;
+	int countFd = mkstemp(countFile);
+	if(countFd < 0)
+	{
+		perror("mkstemp");
+		return 1;
+	}
+	close(countFd);
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	pid_t child = fork();
+	if(child < 0)
+	{
+		perror("fork");
+		return 1;
+	}
+	if(child == 0)
+	{
+		/* Workload on stdin, program output discarded */
+		int input = open(argv[1], O_RDONLY);
+		int output = open("/dev/null", O_WRONLY);
+		if(input < 0 || output < 0)
+		{
+			perror("open");
+			_exit(127);
+		}
+		dup2(input, STDIN_FILENO);
+		dup2(output, STDOUT_FILENO);
+
+		if(countAllocations)
+		{
+			setenv("LD_PRELOAD", library, 1);
+			setenv("MALLOC_COUNT_FILE", countFile, 1);
+		}
+		execv(argv[2], &argv[2]);
+		perror("execv");
+		_exit(127);
+	}
+
+	int status;
+	struct rusage usage;
+	if(wait4(child, &status, 0, &usage) < 0)
+	{
+		perror("wait4");
+		return 1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = elapsedSeconds(start, end);
+
+	unsigned long long allocations = 0;
+	FILE* counts = fopen(countFile, "r");
+	int haveCount = countAllocations && counts != NULL && fscanf(counts, "%llu", &allocations) == 1;
+	if(counts != NULL)
+	{
+		fclose(counts);
+	}
+	unlink(countFile);
+
+	printf("Program:     %s\n", argv[2]);
+	printf("Events:      %ld\n", numEvents);
+	printf("Time:        %.3f s (%.2f M events/s)\n", seconds, numEvents / seconds / 1e6);
+	printf("Peak RSS:    %ld KB\n", usage.ru_maxrss);
+	if(haveCount)
+	{
+		printf("Allocations: %llu (%.3f per event)\n", allocations, (double)allocations / numEvents);
+	}
+	else
+	{
+		printf("Allocations: unavailable (build mallocCount.so next to this driver)\n");
+	}
+
+	if(!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+	{
+		printf("Program did not exit cleanly (status %d)\n", status);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,174 @@
+/*  Taxi Workload Generator
+ *
+ *  Emits a stream of Taxi/Party events in the input format of
+ *  Labs/Lab1/airportTaxi.c or Assessments/Assessment1/vipTaxi.c.
+ *
+ *  Build: gcc -O2 -o taxiWorkload taxiWorkload.c -lm
+ *  Usage: ./taxiWorkload <airport|vip> <numEvents> <poisson|bursty|skewed> [seed] > workload.in
+ *
+ *  poisson: Taxis and parties arrive as two independent Poisson processes
+ *           of equal rate, merged in arrival-time order.
+ *  bursty:  Parties alternate between quiet periods and bursts (Markov
+ *           modulated), taxis keep a steady rate, so the line builds up
+ *           and drains again.
+ *  skewed:  Poisson arrivals, VIP ranks follow a Zipf distribution over
+ *           MAX_RANK + 1 ranks (Rank 0 is the most common).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define MAX_RANK 4095 /* Same rank range as vipTaxi.c */
+#define ZIPF_EXPONENT 1.1
+#define BURST_RATE 1.8 /* Party rate during a burst, relative to the taxi rate */
+#define QUIET_RATE 0.2 /* Party rate outside of bursts (Averages to the taxi rate) */
+#define MEAN_PHASE_LENGTH 2000.0 /* Mean length of a burst/quiet phase (Time units) */
+
+/* --------------- Random number helpers --------------- */
+
+unsigned long long rngState = 88172645463325252ULL;
+
+/* 
+nextRandom: xorshift64* generator.
+@return: A uniformly distributed 64 bit number
+*/
+unsigned long long nextRandom()
+{
+	rngState ^= rngState >> 12;
+	rngState ^= rngState << 25;
+	rngState ^= rngState >> 27;
+	return rngState * 2685821657736338717ULL;
+}
+
+/* 
+uniform: Returns a uniformly distributed number in (0, 1).
+*/
+double uniform()
+{
+	return ((nextRandom() >> 11) + 0.5) / 9007199254740992.0;
+}
+
+/* 
+exponential: Returns the waiting time until the next arrival of a Poisson process.
+@param rate: Arrivals per time unit
+*/
+double exponential(double rate)
+{
+	return -log(uniform()) / rate;
+}
+
+/* 
+buildZipf: Builds the cumulative distribution of a Zipf law over ranks 0 - MAX_RANK.
+@return: Pointer to the cumulative table (Must free)
+*/
+double* buildZipf()
+{
+	double* cumulative = malloc((MAX_RANK + 1) * sizeof(double));
+	if(cumulative == NULL)
+	{
+		printf("Failed to allocate Zipf table\n");
+		exit(1);
+	}
+
+	double total = 0;
+	for (int r = 0; r <= MAX_RANK; ++r)
+	{
+		total += 1.0 / pow(r + 1, ZIPF_EXPONENT);
+		cumulative[r] = total;
+	}
+	for (int r = 0; r <= MAX_RANK; ++r)
+	{
+		cumulative[r] /= total;
+	}
+	return cumulative;
+}
+
+/* 
+sampleZipf: Draws a rank with a binary search over the cumulative table.
+@param cumulative: Pointer to the cumulative table
+@return: The rank
+*/
+int sampleZipf(double* cumulative)
+{
+	double u = uniform();
+	int low = 0;
+	int high = MAX_RANK;
+	while(low < high)
+	{
+		int mid = (low + high) / 2;
+		if(cumulative[mid] < u) low = mid + 1;
+		else high = mid;
+	}
+	return low;
+}
+
+/* --------------- Main --------------- */
+
+int main(int argc, char* argv[])
+{
+	if(argc < 4)
+	{
+		fprintf(stderr, "Usage: %s <airport|vip> <numEvents> <poisson|bursty|skewed> [seed]\n", argv[0]);
+		return 1;
+	}
+
+	int vip = (strcmp(argv[1], "vip") == 0);
+	long numEvents = atol(argv[2]);
+	int bursty = (strcmp(argv[3], "bursty") == 0);
+	int skewed = (strcmp(argv[3], "skewed") == 0);
+	if(argc > 4)
+	{
+		rngState ^= strtoull(argv[4], NULL, 10) * 0x9E3779B97F4A7C15ULL;
+	}
+	double* zipf = skewed ? buildZipf() : NULL;
+
+	/* Next arrival time of each process, taxis arrive at rate 1 */
+	double nextTaxi = exponential(1.0);
+	double nextParty = exponential(1.0);
+	double phaseEnd = exponential(1.0 / MEAN_PHASE_LENGTH);
+	int inBurst = 0;
+
+	static char buffer[1 << 16];
+	setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+
+	printf("%ld\n", numEvents);
+	for (long i = 0; i < numEvents; ++i)
+	{
+		if(nextTaxi <= nextParty)
+		{
+			printf("Taxi\n");
+			nextTaxi += exponential(1.0);
+			continue;
+		}
+
+		/* Names are unique so every party can be told apart in the output */
+		int count = 1 + (int)(nextRandom() % 6);
+		if(vip)
+		{
+			int rank = skewed ? sampleZipf(zipf) : (int)(nextRandom() % 16);
+			printf("Party %d %d P%ld\n", rank, count, i);
+		}
+		else
+		{
+			printf("Party %d P%ld\n", count, i);
+		}
+
+		double rate = 1.0;
+		if(bursty)
+		{
+			/* Switch phase when the party clock passes the end of the current phase */
+			while(nextParty >= phaseEnd)
+			{
+				inBurst = !inBurst;
+				phaseEnd += exponential(1.0 / MEAN_PHASE_LENGTH);
+			}
+			rate = inBurst ? BURST_RATE : QUIET_RATE;
+		}
+		nextParty += exponential(rate);
+	}
+
+	free(zipf);
+	return 0;
+}
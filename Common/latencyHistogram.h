@@ -0,0 +1,103 @@
+/* 
+	Latency Histogram
+	Shared by Labs/Lab1/airportTaxi.c and Assessments/Assessment1/vipTaxi.c.
+
+	Usage: #include "../../Common/latencyHistogram.h" after the standard headers
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#define HIST_SUB_BUCKET_BITS 5 /* 32 linear sub-buckets per power of two (~3% precision) */
+#define HIST_SIZE (32 << HIST_SUB_BUCKET_BITS)
+
+/* --------------- Data structures --------------- */
+
+/* HDR-style histogram: exact below 64, then 32 linear sub-buckets per power of two */
+typedef struct _histogram
+{
+	long long counts[HIST_SIZE];
+	long long total; /* Number of recorded values */
+	int max; /* Largest recorded value */
+} histogram_t;
+
+/* --------------- Histogram implementation --------------- */
+
+/* 
+histogramIndex: Maps a value to its histogram bucket.
+@param value: The value (Negative values count as 0)
+@return: The bucket index
+*/
+int histogramIndex(int value)
+{
+	if(value < (2 << HIST_SUB_BUCKET_BITS))
+	{
+		return (value < 0) ? 0 : value; /* Exact buckets */
+	}
+
+	/* Keep the top HIST_SUB_BUCKET_BITS + 1 bits of the value */
+	int shift = (31 - __builtin_clz(value)) - HIST_SUB_BUCKET_BITS;
+	return (shift << HIST_SUB_BUCKET_BITS) + (value >> shift);
+}
+
+/* 
+histogramBucketMax: Returns the largest value that maps to a bucket.
+@param index: The bucket index
+@return: The highest value of the bucket
+*/
+int histogramBucketMax(int index)
+{
+	if(index < (2 << HIST_SUB_BUCKET_BITS))
+	{
+		return index;
+	}
+
+	int shift = (index >> HIST_SUB_BUCKET_BITS) - 1;
+	int mantissa = index - (shift << HIST_SUB_BUCKET_BITS);
+	return ((mantissa + 1) << shift) - 1;
+}
+
+/* 
+recordValue: Adds a value to a histogram.
+@param _histogram: Pointer to the histogram
+@param value: The value to be recorded
+*/
+void recordValue(histogram_t* _histogram, int value)
+{
+	++_histogram->counts[histogramIndex(value)];
+	++_histogram->total;
+	if(value > _histogram->max)
+	{
+		_histogram->max = value;
+	}
+}
+
+/* 
+valueAtPercentile: Returns the value below which the given share of recorded values fall.
+@param _histogram: Pointer to the histogram
+@param percentile: The percentile (0 - 100)
+@return: The (bucket-precision) value at the percentile, 0 if the histogram is empty
+*/
+int valueAtPercentile(histogram_t* _histogram, double percentile)
+{
+	/* Rank of the value we are looking for, rounded up */
+	long long rank = (long long)(percentile / 100.0 * _histogram->total + 0.999999);
+	if(rank < 1)
+	{
+		rank = 1;
+	}
+
+	long long seen = 0;
+	for (int i = 0; i < HIST_SIZE; ++i)
+	{
+		seen += _histogram->counts[i];
+		if(seen >= rank)
+		{
+			int value = histogramBucketMax(i);
+			return (value > _histogram->max) ? _histogram->max : value;
+		}
+	}
+	return 0;
+}
+
+#endif
@@ -0,0 +1,239 @@
+/* String Pool
+ * 
+ *  Interned names shared by Labs/Lab2/matrilineal.c and
+ *  Assessments/Assessment2/matrilinealDescendant.c.
+ * 
+ *  The including program defines NAME_LENGTH, ARENA_INITIAL_CAPACITY,
+ *  INDEX_INITIAL_SIZE and NO_NODE first. POOL_BEFORE_GROW() runs before
+ *  any of the pool's arrays is reallocated (matrilineal detaches its
+ *  mapped snapshot there).
+ */
+
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#ifndef POOL_BEFORE_GROW
+#define POOL_BEFORE_GROW()
+#endif
+
+/* --------------- Data structures --------------- */
+
+/* Every distinct name once, back to back in one arena, numbered in the order they were
+   first seen. Nodes store the 32-bit id, so comparing two names is comparing two ints. */
+typedef struct _stringpool
+{
+	char* arena; /* Null-terminated names */
+	int* offsets; /* Start of each name in the arena */
+	unsigned int* hashes; /* Full hash of each name, resizing never rehashes */
+	int count;
+	int capacity;
+	int arenaSize; /* Bytes used */
+	int arenaCapacity;
+	int* table; /* Name ids (Linear probing, empty cells hold NO_NODE) */
+	int size; /* Power of two */
+} stringpool_t;
+
+/* --------------- Global variables --------------- */
+
+stringpool_t strings = { NULL, NULL, NULL, 0, 0, 0, 0, NULL, 0 }; /* Every name read so far */
+
+/* ---------- String pool - Linear probing implementation ---------- */
+
+/* 
+growArray: Reallocates one of the growable arrays (Arena, string pool or name index).
+@param _array: Pointer to the array
+@param elemSize: Size of one element in bytes
+@param capacity: The new number of elements
+@return: Pointer to the reallocated array
+*/
+void* growArray(void* _array, size_t elemSize, int capacity)
+{
+	void* newArray = realloc(_array, elemSize * capacity);
+	if(newArray == NULL)
+	{
+		printf("Failed to grow tree arena\n");
+		exit(1);
+	}
+	return newArray;
+}
+
+/* 
+hash: A polynomial string hash function.
+@param key: Pointer to string to be hashed
+@return: Hash function output (Masked by the caller to the table size)
+*/
+unsigned int hash(char* key)
+{
+	unsigned int hash = 0;
+	for (int i = 0; key[i] != '\0'; ++i)
+	{
+		hash = hash * 31 + (unsigned char)key[i];
+	}
+	/* Mix every bit into the masked low bits, similar names would cluster otherwise */
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35u;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+/* 
+stringOf: Returns the name with a given id.
+@param _id: The name id
+@return: Pointer to the name in the string arena
+*/
+char* stringOf(int _id)
+{
+	return strings.arena + strings.offsets[_id];
+}
+
+/* 
+resizeStrings: Moves the string table into one of a new size.
+@param newSize: The new table size (Power of two, more than twice the names)
+*/
+void resizeStrings(int newSize)
+{
+	POOL_BEFORE_GROW();
+	int* newTable = malloc(newSize * sizeof(int));
+	if(newTable == NULL)
+	{
+		printf("Failed to allocate string table\n");
+		exit(1);
+	}
+	for (int i = 0; i < newSize; ++i)
+	{
+		newTable[i] = NO_NODE;
+	}
+	for (int id = 0; id < strings.count; ++id) /* Reinsertion */
+	{
+		int hashKey = strings.hashes[id] & (newSize - 1);
+		while(newTable[hashKey] != NO_NODE)
+		{
+			hashKey = (hashKey + 1) & (newSize - 1);
+		}
+		newTable[hashKey] = id;
+	}
+	free(strings.table);
+	strings.table = newTable;
+	strings.size = newSize;
+}
+
+/* 
+findString: Looks a name up in the string pool without adding it.
+@param _name: The name to search for
+@return: The name id, NO_NODE if the name was never seen
+*/
+int findString(char* _name)
+{
+	if(strings.size == 0)
+	{
+		return NO_NODE;
+	}
+
+	unsigned int nameHash = hash(_name);
+	int hashKey = nameHash & (strings.size - 1);
+	while(strings.table[hashKey] != NO_NODE) /* Loop until cell is empty */
+	{
+		int id = strings.table[hashKey];
+		if(strings.hashes[id] == nameHash && !strcmp(stringOf(id), _name))
+		{
+			return id;
+		}
+		hashKey = (hashKey + 1) & (strings.size - 1); /* Move to next cell */
+	}
+	return NO_NODE;
+}
+
+/* 
+internString: Returns the id of a name (Cut to 20 characters), adding it to the pool if new.
+@param _name: The name to intern
+@return: The name id
+*/
+int internString(char* _name)
+{
+	char name[NAME_LENGTH] = { 0 };
+	strncpy(name, _name, NAME_LENGTH - 1);
+
+	/* Keep the table at most half full, doubling it when needed */
+	if(2 * (strings.count + 1) > strings.size)
+	{
+		resizeStrings((strings.size == 0) ? INDEX_INITIAL_SIZE : strings.size * 2);
+	}
+
+	unsigned int nameHash = hash(name);
+	int hashKey = nameHash & (strings.size - 1);
+	while(strings.table[hashKey] != NO_NODE) /* Loop until cell is empty or holds the name */
+	{
+		int id = strings.table[hashKey];
+		if(strings.hashes[id] == nameHash && !strcmp(stringOf(id), name))
+		{
+			return id;
+		}
+		hashKey = (hashKey + 1) & (strings.size - 1);
+	}
+
+	int length = strlen(name) + 1;
+	if(strings.count == strings.capacity)
+	{
+		POOL_BEFORE_GROW();
+		strings.capacity = (strings.capacity == 0) ? ARENA_INITIAL_CAPACITY : strings.capacity * 2;
+		strings.offsets = growArray(strings.offsets, sizeof(int), strings.capacity);
+		strings.hashes = growArray(strings.hashes, sizeof(int), strings.capacity);
+	}
+	if(strings.arenaSize + length > strings.arenaCapacity)
+	{
+		POOL_BEFORE_GROW();
+		strings.arenaCapacity = (strings.arenaCapacity == 0) ? ARENA_INITIAL_CAPACITY * NAME_LENGTH : strings.arenaCapacity * 2;
+		strings.arena = growArray(strings.arena, 1, strings.arenaCapacity);
+	}
+
+	int id = strings.count++;
+	memcpy(strings.arena + strings.arenaSize, name, length);
+	strings.offsets[id] = strings.arenaSize;
+	strings.hashes[id] = nameHash;
+	strings.arenaSize += length;
+	strings.table[hashKey] = id;
+	return id;
+}
+
+/* 
+freeStrings: Free the string pool.
+*/
+void freeStrings()
+{
+	free(strings.arena);
+	free(strings.offsets);
+	free(strings.hashes);
+	free(strings.table);
+	memset(&strings, 0, sizeof(stringpool_t));
+}
+
+/* ---------- Input ---------- */
+
+/* 
+readName: Reads the next whitespace-separated word from stdin, cut to 24 characters.
+	Character-level reads keep the loader from spending most of its time in scanf.
+@param _name: Buffer of at least 25 characters
+*/
+void readName(char* _name)
+{
+	int c = getchar_unlocked();
+	while(c == ' ' || c == '\n' || c == '\r' || c == '\t')
+	{
+		c = getchar_unlocked();
+	}
+
+	int length = 0;
+	while(c != EOF && c != ' ' && c != '\n' && c != '\r' && c != '\t')
+	{
+		if(length < 24)
+		{
+			_name[length++] = (char)c;
+		}
+		c = getchar_unlocked();
+	}
+	_name[length] = '\0';
+}
+
+#endif
@@ -2,168 +2,729 @@
 	Airport Taxi Queue Template
  	Created by Pasin Manurangsi, 2025-01-08
 	Modified by Luka Bond, 2025-01-24
+
+	Usage: ./airportTaxi [--stats] < input  (--stats prints wait/idle percentiles at the end)
+	       ./airportTaxi --terminals < input  (Events are "Taxi <terminal>" / "Party <terminal> <count> <name>")
+	       ./airportTaxi --concurrent < input (Same events as the first, through the lock-free dispatcher)
 */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include <pthread.h>
 
-/* --------------- Data structures --------------- */
+#include "../../Common/latencyHistogram.h"
 
-/* Singly linked list node */
-typedef struct _node
-{
-	void* data;
-	struct _node* nextNode;
-} node_t;
+#define QUEUE_INITIAL_CAPACITY 16 /* Must be a power of two */
+#define CACHE_LINE_SIZE 64
+#define MAX_TERMINALS 1024
 
-/* Linked List */
-typedef struct _linkedlist
+/* --------------- Data structures --------------- */
+
+/* Growable ring buffer queue, elements are stored by value */
+typedef struct _ringqueue
 {
-	node_t* head;
-	node_t* tail;
-} linkedlist_t;
+	char* buffer; /* Contiguous storage of (capacity * elemSize) bytes */
+	size_t elemSize; /* Size of a single element in bytes */
+	int head; /* Index of the front element */
+	int count; /* Number of elements currently stored */
+	int capacity; /* Number of element slots (Power of two) */
+} ringqueue_t;
 
 /* Party/Group structure */
 typedef struct _party
 {
 	int amount;
 	char name[20];
+	int arrivalTime; /* Timestep at which the party joined the line */
 
 } party_t;
 
+/* Taxi waiting in the taxi queue */
+typedef struct _taxi
+{
+	int id;
+	int arrivalTime; /* Timestep at which the taxi joined the queue */
+} taxi_t;
+
+/* Queueing latency instrumentation, in timesteps */
+typedef struct _queuestats
+{
+	histogram_t partyWait; /* Time from party arrival to pick up */
+	histogram_t taxiIdle; /* Time from taxi arrival to pick up */
+	int maxPartyDepth; /* Longest the party line has been */
+	int maxTaxiDepth; /* Longest the taxi queue has been */
+} queuestats_t;
+
+/* A taxi or party handed through the concurrent dispatcher */
+typedef struct _arrival
+{
+	int taxiId;
+	party_t party;
+} arrival_t;
+
+/* Slot of the lock-free queue, the sequence number tells whether it is ready to be written or read */
+typedef struct _mpmccell
+{
+	atomic_size_t sequence;
+	arrival_t item;
+} mpmccell_t;
+
+/* Bounded lock-free multi-producer multi-consumer queue */
+typedef struct _mpmcqueue
+{
+	mpmccell_t* cells;
+	size_t mask; /* Capacity - 1 (Capacity is a power of two) */
+	_Alignas(CACHE_LINE_SIZE) atomic_size_t enqueuePos; /* Producers and consumers on separate lines */
+	_Alignas(CACHE_LINE_SIZE) atomic_size_t dequeuePos;
+} mpmcqueue_t;
+
+/* Concurrent taxi/party dispatcher, safe to call from any number of threads */
+typedef struct _dispatcher
+{
+	mpmcqueue_t partyQueue;
+	mpmcqueue_t taxiQueue;
+	_Alignas(CACHE_LINE_SIZE) atomic_long balance; /* > 0: parties waiting, < 0: taxis waiting */
+	_Alignas(CACHE_LINE_SIZE) atomic_int taxiRegistration;
+	atomic_int servedGroups;
+} dispatcher_t;
+
+/* Taxi/Party event routed to a terminal in sharded mode */
+typedef struct _event
+{
+	int isParty;
+	int timestep;
+	party_t party;
+} event_t;
+
+/* A terminal's taxi stand, owns its own pair of queues and counters */
+typedef struct _terminal
+{
+	ringqueue_t partyQueue; /* Holds party_t by value */
+	ringqueue_t taxiQueue; /* Holds taxi_t by value */
+	int taxiRegistration;
+	int servedGroups;
+	int inlineGroups;
+	FILE* out; /* Where pick ups are reported */
+	queuestats_t stats;
+
+	/* Sharded mode only */
+	ringqueue_t events; /* Holds event_t by value, in arrival order */
+	char* outBuffer; /* Pick ups buffered by the worker, merged by the main thread */
+	size_t outSize;
+	pthread_t worker;
+} terminal_t;
+
 /* --------------- Global variables --------------- */
 
-linkedlist_t partyQueue = { NULL, NULL };
-linkedlist_t taxiQueue = { NULL, NULL };
-int taxiRegistration = 1;
-int servedGroups = 0; 
-int inlineGroups = 0; 
+terminal_t airport = { /* Single terminal mode, every other member starts zeroed */
+	.partyQueue = { NULL, sizeof(party_t), 0, 0, 0 },
+	.taxiQueue = { NULL, sizeof(taxi_t), 0, 0, 0 },
+	.taxiRegistration = 1
+};
+terminal_t* terminals[MAX_TERMINALS] = { NULL }; /* Sharded mode, indexed by terminal ID */
 
-/* --------------- Linked list-based Queue implementation --------------- */
+/* --------------- Ring buffer-based Queue implementation --------------- */
 
 /* 
-Enqueue: Add data (of any type) to a specified queue.
-@param _data: Pointer to data (of any type) to be stored
+growQueue: Doubles the capacity of a queue, unwrapping its elements so the front is at index 0.
 @param _queue: Pointer to the queue
 */
-void enqueue(void* _data, linkedlist_t* _queue)
+void growQueue(ringqueue_t* _queue)
 {
-	node_t* newNode = calloc(1, sizeof(node_t));
-	if(newNode == NULL)
+	int newCapacity = (_queue->capacity == 0) ? QUEUE_INITIAL_CAPACITY : _queue->capacity * 2;
+	char* newBuffer = malloc((size_t)newCapacity * _queue->elemSize);
+	if(newBuffer == NULL)
 	{
-		printf("Failed to allocate new node\n");
+		printf("Failed to grow queue buffer\n");
 		exit(1);
 	}
 
-	/* Filling node attributes */
-	newNode->data = _data; /* Fill data */
-	newNode->nextNode = NULL; /* No next node (new tail) */
-	
-	if(_queue->tail != NULL)
+	/* Elements from head to the end of the old buffer, then the wrapped-around part */
+	int firstPart = _queue->capacity - _queue->head;
+	if(firstPart > _queue->count)
 	{
-		/* Next node of current tail is the new node */
-		(_queue->tail)->nextNode = newNode;
+		firstPart = _queue->count;
 	}
-
-	/* Queue is empty */
-	if(_queue->head == NULL)
+	if(_queue->count > 0)
 	{
-		_queue->head = newNode;
+		memcpy(newBuffer, _queue->buffer + (size_t)_queue->head * _queue->elemSize, (size_t)firstPart * _queue->elemSize);
+		memcpy(newBuffer + (size_t)firstPart * _queue->elemSize, _queue->buffer, (size_t)(_queue->count - firstPart) * _queue->elemSize);
 	}
-	_queue->tail = newNode; /* Reassigning the tail*/
+
+	free(_queue->buffer);
+	_queue->buffer = newBuffer;
+	_queue->head = 0;
+	_queue->capacity = newCapacity;
 }
 
 /* 
-Dequeue: Remove data (of any type) from a specified queue.
+Enqueue: Copy an element to the back of a specified queue.
+@param _data: Pointer to the element (elemSize bytes are copied)
 @param _queue: Pointer to the queue
-@return: Pointer to the allocated data
 */
-void* dequeue(linkedlist_t* _queue)
-{	
-	if(_queue->head == NULL)
+void enqueue(const void* _data, ringqueue_t* _queue)
+{
+	if(_queue->count == _queue->capacity)
 	{
-		return NULL;
+		growQueue(_queue);
 	}
 
-	node_t* prevHead = _queue->head;
-	void* item = (_queue->head)->data;
-	
+	/* Capacity is a power of two, so the mask wraps the index around */
+	int tail = (_queue->head + _queue->count) & (_queue->capacity - 1);
+	memcpy(_queue->buffer + (size_t)tail * _queue->elemSize, _data, _queue->elemSize);
+	++_queue->count;
+}
 
-	/* Reassign new head */
-	_queue->head = (_queue->head)->nextNode;
+/* 
+Dequeue: Remove the front element of a specified queue and copy it out.
+@param _out: Pointer to where the element will be copied (May be NULL to discard)
+@param _queue: Pointer to the queue
+@return: 1 if an element was removed, 0 if the queue is empty
+*/
+int dequeue(void* _out, ringqueue_t* _queue)
+{	
+	if(_queue->count == 0)
+	{
+		return 0;
+	}
 
-	/* Free and set old pointer to NULL*/
-	free(prevHead);
-	prevHead = NULL;
+	if(_out != NULL)
+	{
+		memcpy(_out, _queue->buffer + (size_t)_queue->head * _queue->elemSize, _queue->elemSize);
+	}
 
-	return item;
+	/* Advance the head, no memory is released */
+	_queue->head = (_queue->head + 1) & (_queue->capacity - 1);
+	--_queue->count;
+	return 1;
 }
 
 /* 
-freeAll: Free all of the contents from the queue
+freeAll: Free the buffer of the queue and reset it to empty
 @param _queue: Pointer to the queue
 */
-void freeAll(linkedlist_t* _queue)
+void freeAll(ringqueue_t* _queue)
 {
-	while(_queue->head != NULL)
+	free(_queue->buffer);
+	_queue->buffer = NULL;
+	_queue->head = 0;
+	_queue->count = 0;
+	_queue->capacity = 0;
+}
+
+/* --------------- Queueing latency instrumentation --------------- */
+
+
+/* 
+mergeStats: Adds the recorded values of one set of stats into another.
+@param _into: Pointer to the stats being accumulated
+@param _from: Pointer to the stats to be added
+*/
+void mergeStats(queuestats_t* _into, queuestats_t* _from)
+{
+	histogram_t* into[2] = { &_into->partyWait, &_into->taxiIdle };
+	histogram_t* from[2] = { &_from->partyWait, &_from->taxiIdle };
+	for (int h = 0; h < 2; ++h)
+	{
+		for (int i = 0; i < HIST_SIZE; ++i)
+		{
+			into[h]->counts[i] += from[h]->counts[i];
+		}
+		into[h]->total += from[h]->total;
+		if(from[h]->max > into[h]->max)
+		{
+			into[h]->max = from[h]->max;
+		}
+	}
+
+	if(_from->maxPartyDepth > _into->maxPartyDepth)
+	{
+		_into->maxPartyDepth = _from->maxPartyDepth;
+	}
+	if(_from->maxTaxiDepth > _into->maxTaxiDepth)
 	{
-		void* _data = dequeue(_queue); /* Dequeue frees each node already */
-		free(_data);
-		_data = NULL;
+		_into->maxTaxiDepth = _from->maxTaxiDepth;
 	}
 }
 
+/* 
+printStats: Prints the wait/idle percentiles and maximum queue depths.
+@param _stats: Pointer to the stats
+@param out: The stream to print to
+*/
+void printStats(queuestats_t* _stats, FILE* out)
+{
+	histogram_t* wait = &_stats->partyWait;
+	histogram_t* idle = &_stats->taxiIdle;
+	fprintf(out, "Party wait: p50 %d, p99 %d, p999 %d, max %d timesteps\n",
+		valueAtPercentile(wait, 50), valueAtPercentile(wait, 99), valueAtPercentile(wait, 99.9), wait->max);
+	fprintf(out, "Taxi idle: p50 %d, p99 %d, p999 %d, max %d timesteps\n",
+		valueAtPercentile(idle, 50), valueAtPercentile(idle, 99), valueAtPercentile(idle, 99.9), idle->max);
+	fprintf(out, "Max queue depth: %d parties, %d taxis\n", _stats->maxPartyDepth, _stats->maxTaxiDepth);
+}
+
 /* --------------- Taxi/Party arrival --------------- */
 
 /* 
-partyArrival: Handles an arrival of a new taxi
+taxiArrival: Handles an arrival of a new taxi
+@param _terminal: Pointer to the terminal the taxi arrives at
+@param timestep: The current timestep
 */
-void taxiArrival()
+void taxiArrival(terminal_t* _terminal, int timestep)
 {
-	party_t* _party = dequeue(&partyQueue);
-	if(_party == NULL) /* If there are no parties, Queue taxi */
+	party_t _party;
+	if(!dequeue(&_party, &_terminal->partyQueue)) /* If there are no parties, Queue taxi */
 	{
-		enqueue((void*)(uintptr_t)taxiRegistration, &taxiQueue);
+		taxi_t newTaxi = { _terminal->taxiRegistration, timestep };
+		enqueue(&newTaxi, &_terminal->taxiQueue);
+		if(_terminal->taxiQueue.count > _terminal->stats.maxTaxiDepth)
+		{
+			_terminal->stats.maxTaxiDepth = _terminal->taxiQueue.count;
+		}
 	}
 	else 
 	{
-		printf("Taxi %d (Arriving Taxi): Pick up party %s with %d people.\n",  taxiRegistration, _party->name, _party->amount);
-		++servedGroups;
-		--inlineGroups;
-
-		free(_party);
-		_party = NULL;
+		fprintf(_terminal->out, "Taxi %d (Arriving Taxi): Pick up party %s with %d people.\n",  _terminal->taxiRegistration, _party.name, _party.amount);
+		++_terminal->servedGroups;
+		--_terminal->inlineGroups;
+		recordValue(&_terminal->stats.partyWait, timestep - _party.arrivalTime);
+		recordValue(&_terminal->stats.taxiIdle, 0);
 	}
-	++taxiRegistration;
+	++_terminal->taxiRegistration;
 }
 
 /* 
 partyArrival: Handles an arrival of a new party.
+@param _terminal: Pointer to the terminal the party arrives at
 @param count: The number of people in the party
 @param partyName: The name of the party
+@param timestep: The current timestep
 */
-void partyArrival(int count, char partyName[])
+void partyArrival(terminal_t* _terminal, int count, char partyName[], int timestep)
 {
-	if(taxiQueue.head != NULL) /* If there is a taxi, immediate departure (No queue) */
+	taxi_t _taxi;
+	if(dequeue(&_taxi, &_terminal->taxiQueue)) /* If there is a taxi, immediate departure (No queue) */
 	{
-		printf("Taxi %d (Queued Taxi): Pick up party %s with %d people.\n", (int)(uintptr_t)dequeue(&taxiQueue), partyName, count);
-		++servedGroups;
+		fprintf(_terminal->out, "Taxi %d (Queued Taxi): Pick up party %s with %d people.\n", _taxi.id, partyName, count);
+		++_terminal->servedGroups;
+		recordValue(&_terminal->stats.partyWait, 0);
+		recordValue(&_terminal->stats.taxiIdle, timestep - _taxi.arrivalTime);
 		return;
 	}
 
-	party_t* newParty = calloc(1, sizeof(party_t));
-	if(newParty == NULL) 
+	/* Party is copied into the queue buffer, no per-party allocation */
+	party_t newParty = { 0 };
+	newParty.amount = count;
+	strncpy(newParty.name, partyName, sizeof(newParty.name) - 1);
+	newParty.arrivalTime = timestep;
+	enqueue(&newParty, &_terminal->partyQueue);
+	++_terminal->inlineGroups;
+	if(_terminal->partyQueue.count > _terminal->stats.maxPartyDepth)
+	{
+		_terminal->stats.maxPartyDepth = _terminal->partyQueue.count;
+	}
+}	
+
+/* --------------- Multi-terminal sharded engine --------------- */
+
+/* 
+getTerminal: Returns the terminal with the given ID, creating it on first use.
+@param terminalId: The terminal ID (0 to MAX_TERMINALS - 1)
+@return: Pointer to the terminal, NULL if the ID is out of range
+*/
+terminal_t* getTerminal(int terminalId)
+{
+	if(terminalId < 0 || terminalId >= MAX_TERMINALS)
+	{
+		return NULL;
+	}
+
+	if(terminals[terminalId] == NULL)
 	{
-		printf("Failed to allocate new party\n");
+		terminal_t* newTerminal = calloc(1, sizeof(terminal_t));
+		if(newTerminal == NULL)
+		{
+			printf("Failed to allocate new terminal\n");
+			exit(1);
+		}
+		newTerminal->partyQueue.elemSize = sizeof(party_t);
+		newTerminal->taxiQueue.elemSize = sizeof(taxi_t);
+		newTerminal->events.elemSize = sizeof(event_t);
+		newTerminal->taxiRegistration = 1; /* Each terminal registers its own taxis */
+		terminals[terminalId] = newTerminal;
+	}
+	return terminals[terminalId];
+}
+
+/* 
+routeEvent: Queues a Taxi/Party event for the terminal's worker.
+@param terminalId: The terminal the event belongs to
+@param isParty: 0 for a taxi, 1 for a party
+@param count: The number of people in the party
+@param partyName: The name of the party
+@param timestep: The timestep of the event
+*/
+void routeEvent(int terminalId, int isParty, int count, char partyName[], int timestep)
+{
+	terminal_t* terminal = getTerminal(terminalId);
+	if(terminal == NULL)
+	{
+		printf("Invalid terminal %d\n", terminalId);
+		return;
+	}
+
+	event_t newEvent = { 0 };
+	newEvent.isParty = isParty;
+	newEvent.timestep = timestep;
+	if(isParty)
+	{
+		newEvent.party.amount = count;
+		snprintf(newEvent.party.name, sizeof(newEvent.party.name), "%s", partyName);
+	}
+	enqueue(&newEvent, &terminal->events);
+}
+
+/* 
+runTerminal: Worker thread, replays one terminal's events in order into its own output buffer.
+@param _arg: Pointer to the terminal
+*/
+void* runTerminal(void* _arg)
+{
+	terminal_t* terminal = _arg;
+	terminal->out = open_memstream(&terminal->outBuffer, &terminal->outSize);
+	if(terminal->out == NULL)
+	{
+		printf("Failed to open terminal output\n");
 		exit(1);
 	}
 
-	newParty->amount = count;
-	strncpy(newParty->name, partyName, 20);
-	enqueue(newParty, &partyQueue);
-	++inlineGroups;
-}	
+	event_t _event;
+	while(dequeue(&_event, &terminal->events))
+	{
+		if(_event.isParty)
+		{
+			partyArrival(terminal, _event.party.amount, _event.party.name, _event.timestep);
+		}
+		else
+		{
+			taxiArrival(terminal, _event.timestep);
+		}
+	}
+
+	fclose(terminal->out); /* Flushes outBuffer/outSize */
+	terminal->out = NULL;
+	return NULL;
+}
+
+/* 
+runTerminals: Runs every terminal on its own worker thread, then prints
+	their outputs in ascending terminal ID order so the result is deterministic.
+@param printQueueStats: Whether the per-terminal and total stats are printed
+*/
+void runTerminals(int printQueueStats)
+{
+	for (int i = 0; i < MAX_TERMINALS; ++i)
+	{
+		if(terminals[i] != NULL && pthread_create(&terminals[i]->worker, NULL, runTerminal, terminals[i]) != 0)
+		{
+			printf("Failed to start terminal worker\n");
+			exit(1);
+		}
+	}
+
+	int servedGroups = 0;
+	int inlineGroups = 0;
+	queuestats_t* totalStats = calloc(1, sizeof(queuestats_t));
+	if(totalStats == NULL)
+	{
+		printf("Failed to allocate stats\n");
+		exit(1);
+	}
+	for (int i = 0; i < MAX_TERMINALS; ++i)
+	{
+		terminal_t* terminal = terminals[i];
+		if(terminal == NULL)
+		{
+			continue;
+		}
+
+		/* Merge in terminal order, waiting for each worker in turn */
+		pthread_join(terminal->worker, NULL);
+		printf("Terminal %d\n", i);
+		fwrite(terminal->outBuffer, 1, terminal->outSize, stdout);
+		printf("Served: %d groups, In line: %d groups\n", terminal->servedGroups, terminal->inlineGroups);
+		if(printQueueStats)
+		{
+			printStats(&terminal->stats, stdout);
+		}
+		printf("\n");
+		servedGroups += terminal->servedGroups;
+		inlineGroups += terminal->inlineGroups;
+		mergeStats(totalStats, &terminal->stats);
+
+		free(terminal->outBuffer);
+		freeAll(&terminal->events);
+		freeAll(&terminal->partyQueue);
+		freeAll(&terminal->taxiQueue);
+		free(terminal);
+		terminals[i] = NULL;
+	}
+	printf("Served: %d groups, In line: %d groups\n", servedGroups, inlineGroups);
+	if(printQueueStats)
+	{
+		printStats(totalStats, stdout);
+	}
+	free(totalStats);
+}
+
+/* --------------- Lock-free MPMC Queue implementation --------------- */
+
+/* 
+initMPMCQueue: Allocates the cells of a lock-free queue.
+@param _queue: Pointer to the queue
+@param capacity: The number of cells (Rounded up to a power of two)
+*/
+void initMPMCQueue(mpmcqueue_t* _queue, size_t capacity)
+{
+	size_t size = 2;
+	while(size < capacity)
+	{
+		size *= 2;
+	}
+
+	_queue->cells = calloc(size, sizeof(mpmccell_t));
+	if(_queue->cells == NULL)
+	{
+		printf("Failed to allocate lock-free queue\n");
+		exit(1);
+	}
+
+	/* Cell i is first writable when enqueuePos reaches i */
+	for (size_t i = 0; i < size; ++i)
+	{
+		atomic_init(&_queue->cells[i].sequence, i);
+	}
+	_queue->mask = size - 1;
+	atomic_init(&_queue->enqueuePos, 0);
+	atomic_init(&_queue->dequeuePos, 0);
+}
+
+/* 
+freeMPMCQueue: Frees the cells of a lock-free queue.
+@param _queue: Pointer to the queue
+*/
+void freeMPMCQueue(mpmcqueue_t* _queue)
+{
+	free(_queue->cells);
+	_queue->cells = NULL;
+}
+
+/* 
+mpmcEnqueue: Copy an item to the back of a lock-free queue.
+@param _item: Pointer to the item
+@param _queue: Pointer to the queue
+@return: 1 if the item was added, 0 if the queue is full
+*/
+int mpmcEnqueue(const arrival_t* _item, mpmcqueue_t* _queue)
+{
+	size_t pos = atomic_load_explicit(&_queue->enqueuePos, memory_order_relaxed);
+	for (;;)
+	{
+		mpmccell_t* cell = &_queue->cells[pos & _queue->mask];
+		size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+		long diff = (long)sequence - (long)pos;
+
+		if(diff == 0) /* Cell is free, try to claim it */
+		{
+			if(atomic_compare_exchange_weak_explicit(&_queue->enqueuePos, &pos, pos + 1,
+				memory_order_relaxed, memory_order_relaxed))
+			{
+				cell->item = *_item;
+				atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release); /* Publish */
+				return 1;
+			}
+		}
+		else if(diff < 0) /* Cell still holds an unread item from the previous lap */
+		{
+			return 0;
+		}
+		else /* Another producer claimed it, reload the position */
+		{
+			pos = atomic_load_explicit(&_queue->enqueuePos, memory_order_relaxed);
+		}
+	}
+}
+
+/* 
+mpmcDequeue: Remove the front item of a lock-free queue and copy it out.
+@param _out: Pointer to where the item will be copied
+@param _queue: Pointer to the queue
+@return: 1 if an item was removed, 0 if the queue is empty
+*/
+int mpmcDequeue(arrival_t* _out, mpmcqueue_t* _queue)
+{
+	size_t pos = atomic_load_explicit(&_queue->dequeuePos, memory_order_relaxed);
+	for (;;)
+	{
+		mpmccell_t* cell = &_queue->cells[pos & _queue->mask];
+		size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+		long diff = (long)sequence - (long)(pos + 1);
+
+		if(diff == 0) /* Cell is published, try to claim it */
+		{
+			if(atomic_compare_exchange_weak_explicit(&_queue->dequeuePos, &pos, pos + 1,
+				memory_order_relaxed, memory_order_relaxed))
+			{
+				*_out = cell->item;
+				/* Make the cell writable again for the next lap */
+				atomic_store_explicit(&cell->sequence, pos + _queue->mask + 1, memory_order_release);
+				return 1;
+			}
+		}
+		else if(diff < 0) /* Nothing published yet */
+		{
+			return 0;
+		}
+		else /* Another consumer claimed it, reload the position */
+		{
+			pos = atomic_load_explicit(&_queue->dequeuePos, memory_order_relaxed);
+		}
+	}
+}
+
+/* --------------- Concurrent Taxi/Party dispatcher --------------- */
+
+/* 
+initDispatcher: Prepares a dispatcher for concurrent use.
+	Both queues are bounded, arrivals wait for space when more than capacity are waiting.
+@param _dispatcher: Pointer to the dispatcher
+@param capacity: The maximum number of waiting parties (and of waiting taxis)
+*/
+void initDispatcher(dispatcher_t* _dispatcher, size_t capacity)
+{
+	initMPMCQueue(&_dispatcher->partyQueue, capacity);
+	initMPMCQueue(&_dispatcher->taxiQueue, capacity);
+	atomic_init(&_dispatcher->balance, 0);
+	atomic_init(&_dispatcher->taxiRegistration, 1);
+	atomic_init(&_dispatcher->servedGroups, 0);
+}
+
+/* 
+freeDispatcher: Frees both queues of a dispatcher.
+@param _dispatcher: Pointer to the dispatcher
+*/
+void freeDispatcher(dispatcher_t* _dispatcher)
+{
+	freeMPMCQueue(&_dispatcher->partyQueue);
+	freeMPMCQueue(&_dispatcher->taxiQueue);
+}
+
+/* 
+concurrentTaxiArrival: Handles an arrival of a new taxi (Thread-safe).
+	The balance counter decides who waits: only one side can be ahead, so at most
+	one of the two queues is ever (logically) non-empty.
+@param _dispatcher: Pointer to the dispatcher
+@param _match: Filled with the taxi and the picked up party when a match happens
+@return: 1 if the taxi picked up a waiting party, 0 if the taxi was queued
+*/
+int concurrentTaxiArrival(dispatcher_t* _dispatcher, arrival_t* _match)
+{
+	arrival_t taxi = { 0 };
+	taxi.taxiId = atomic_fetch_add(&_dispatcher->taxiRegistration, 1);
+
+	if(atomic_fetch_sub(&_dispatcher->balance, 1) > 0) /* A party is waiting */
+	{
+		/* The party has reserved its place but may not have been published yet */
+		while(!mpmcDequeue(_match, &_dispatcher->partyQueue))
+		{
+			sched_yield();
+		}
+		_match->taxiId = taxi.taxiId;
+		atomic_fetch_add_explicit(&_dispatcher->servedGroups, 1, memory_order_relaxed);
+		return 1;
+	}
+
+	while(!mpmcEnqueue(&taxi, &_dispatcher->taxiQueue)) /* Queue is full, wait for parties */
+	{
+		sched_yield();
+	}
+	return 0;
+}
+
+/* 
+concurrentPartyArrival: Handles an arrival of a new party (Thread-safe).
+@param _dispatcher: Pointer to the dispatcher
+@param count: The number of people in the party
+@param partyName: The name of the party
+@param _match: Filled with the queued taxi and the party when a match happens
+@return: 1 if a queued taxi picked up the party, 0 if the party was queued
+*/
+int concurrentPartyArrival(dispatcher_t* _dispatcher, int count, char partyName[], arrival_t* _match)
+{
+	arrival_t party = { 0 };
+	party.party.amount = count;
+	snprintf(party.party.name, sizeof(party.party.name), "%s", partyName);
+
+	if(atomic_fetch_add(&_dispatcher->balance, 1) < 0) /* A taxi is waiting */
+	{
+		while(!mpmcDequeue(_match, &_dispatcher->taxiQueue))
+		{
+			sched_yield();
+		}
+		_match->party = party.party;
+		atomic_fetch_add_explicit(&_dispatcher->servedGroups, 1, memory_order_relaxed);
+		return 1;
+	}
+
+	while(!mpmcEnqueue(&party, &_dispatcher->partyQueue)) /* Queue is full, wait for taxis */
+	{
+		sched_yield();
+	}
+	return 0;
+}
+
+/* 
+runConcurrent: Reads every event and hands it to the concurrent dispatcher from this
+	thread, reporting pick ups as in single terminal mode. The dispatcher has room for
+	every arrival, so a single thread never waits on a full queue.
+@param timesteps: The number of events to read
+*/
+void runConcurrent(int timesteps)
+{
+	char input[10];
+	char name[20];
+	int count;
+	arrival_t match;
+	dispatcher_t dispatcher;
+	initDispatcher(&dispatcher, timesteps);
+
+	for (int i = 0 ; i < timesteps ; i ++)
+	{
+		scanf("\n%s", input);
+		if (strcmp(input, "Taxi") == 0)
+		{
+			if (concurrentTaxiArrival(&dispatcher, &match))
+			{
+				printf("Taxi %d (Arriving Taxi): Pick up party %s with %d people.\n", match.taxiId, match.party.name, match.party.amount);
+			}
+		}
+		else if(strcmp(input, "Party") == 0)
+		{
+			scanf(" %d %s", &count, name);
+			if (concurrentPartyArrival(&dispatcher, count, name, &match))
+			{
+				printf("Taxi %d (Queued Taxi): Pick up party %s with %d people.\n", match.taxiId, match.party.name, match.party.amount);
+			}
+		}
+	}
+
+	long balance = atomic_load(&dispatcher.balance); /* Parties still waiting when positive */
+	printf("\nServed: %d groups, In line: %ld groups\n", atomic_load(&dispatcher.servedGroups), (balance > 0) ? balance : 0);
+	freeDispatcher(&dispatcher);
+}
 
 /* --------------- Main --------------- */
 
@@ -178,21 +739,54 @@ int main(int argc, char* argv[])
 
  	char name[20]; // The party name 
  	int count; // The number of people in the party
+ 	int terminalId = 0; // The terminal of the event (Sharded mode)
+
+ 	int sharded = 0; // --terminals: One stand per terminal, each on its own thread
+ 	int concurrent = 0; // --concurrent: Through the lock-free dispatcher
+ 	int printQueueStats = 0; // --stats: Wait/idle percentiles after the summary
+ 	for (int i = 1; i < argc; ++i)
+ 	{
+ 		if (strcmp(argv[i], "--terminals") == 0) sharded = 1;
+ 		else if (strcmp(argv[i], "--concurrent") == 0) concurrent = 1;
+ 		else if (strcmp(argv[i], "--stats") == 0) printQueueStats = 1;
+ 	}
+ 	airport.out = stdout;
 
  	scanf("%d", &timesteps);
+ 	if (concurrent)
+ 	{
+ 		runConcurrent(timesteps);
+ 		return 0;
+ 	}
  	for (int i = 0 ; i < timesteps ; i ++)
  	{
  		scanf("\n%s", input);
+ 		if (sharded)
+ 		{
+ 			scanf(" %d", &terminalId);
+ 		}
+
  		if (strcmp(input, "Taxi") == 0)
  		{
- 			taxiArrival();
+ 			if (sharded) routeEvent(terminalId, 0, 0, NULL, i);
+ 			else taxiArrival(&airport, i);
  		}
  		else if(strcmp(input, "Party") == 0)
  		{
  			scanf(" %d %s", &count, name);
- 			partyArrival(count, name);
+ 			if (sharded) routeEvent(terminalId, 1, count, name, i);
+ 			else partyArrival(&airport, count, name, i);
  		}
  	}
- 	freeAll(&partyQueue);
-	printf("\nServed: %d groups, In line: %d groups", servedGroups, inlineGroups);
+
+ 	if (sharded)
+ 	{
+ 		runTerminals(printQueueStats);
+ 		return 0;
+ 	}
+ 	freeAll(&airport.partyQueue);
+ 	freeAll(&airport.taxiQueue);
+	printf("\nServed: %d groups, In line: %d groups\n", airport.servedGroups, airport.inlineGroups);
+	if (printQueueStats) printStats(&airport.stats, stdout);
+	return 0;
 }
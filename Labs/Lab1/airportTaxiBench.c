@@ -0,0 +1,243 @@
+/*
+	Airport Taxi Queue Benchmark
+	Compares the ring buffer queue in airportTaxi.c against the original
+	calloc-per-node linked list queue on a long random Taxi/Party stream.
+
+	Build: gcc -O2 -o airportTaxiBench airportTaxiBench.c
+	Usage: ./airportTaxiBench [numEvents]
+*/
+
+#define main airportTaxiMain
+#include "airportTaxi.c"
+#undef main
+
+#include <stdint.h>
+#include <time.h>
+
+/* --------------- Original linked list-based Queue --------------- */
+
+/* Singly linked list node */
+typedef struct _node
+{
+	void* data;
+	struct _node* nextNode;
+} node_t;
+
+/* Linked List */
+typedef struct _linkedlist
+{
+	node_t* head;
+	node_t* tail;
+} linkedlist_t;
+
+/*
+listEnqueue: Add data (of any type) to a specified queue (One calloc per node).
+@param _data: Pointer to data (of any type) to be stored
+@param _queue: Pointer to the queue
+*/
+void listEnqueue(void* _data, linkedlist_t* _queue)
+{
+	node_t* newNode = calloc(1, sizeof(node_t));
+	if(newNode == NULL)
+	{
+		printf("Failed to allocate new node\n");
+		exit(1);
+	}
+	newNode->data = _data;
+	newNode->nextNode = NULL;
+	if(_queue->tail != NULL)
+	{
+		(_queue->tail)->nextNode = newNode;
+	}
+	if(_queue->head == NULL)
+	{
+		_queue->head = newNode;
+	}
+	_queue->tail = newNode;
+}
+
+/*
+listDequeue: Remove data (of any type) from a specified queue (One free per node).
+@param _queue: Pointer to the queue
+@return: Pointer to the allocated data
+*/
+void* listDequeue(linkedlist_t* _queue)
+{
+	if(_queue->head == NULL)
+	{
+		return NULL;
+	}
+	node_t* prevHead = _queue->head;
+	void* item = prevHead->data;
+	_queue->head = prevHead->nextNode;
+	if(_queue->head == NULL)
+	{
+		_queue->tail = NULL;
+	}
+	free(prevHead);
+	return item;
+}
+
+/* --------------- Benchmark --------------- */
+
+/*
+elapsedSeconds: Returns the seconds elapsed between two timestamps.
+@param start: The earlier timestamp
+@param end: The later timestamp
+@return: Elapsed time in seconds
+*/
+double elapsedSeconds(struct timespec start, struct timespec end)
+{
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/*
+generateEvents: Fills an array with a bursty random Taxi(0)/Party(1) stream.
+	Parties outnumber taxis for a phase, then taxis catch up, so both queues grow.
+@param events: The array to be filled
+@param numEvents: The number of events
+*/
+void generateEvents(char* events, int numEvents)
+{
+	unsigned int seed = 12345;
+	for (int i = 0; i < numEvents; ++i)
+	{
+		seed = seed * 1103515245u + 12345u;
+		int partyPercent = ((i >> 12) & 1) ? 40 : 60; /* Switch phase every 4096 events */
+		events[i] = (int)((seed >> 16) % 100) < partyPercent;
+	}
+}
+
+/*
+runList: Replays the stream with the original linked list queues.
+@return: Checksum of all (taxi, party) matches
+*/
+long long runList(const char* events, int numEvents)
+{
+	linkedlist_t parties = { NULL, NULL };
+	linkedlist_t taxis = { NULL, NULL };
+	long long checksum = 0;
+	int taxiId = 1;
+
+	for (int i = 0; i < numEvents; ++i)
+	{
+		if(events[i] == 0)
+		{
+			party_t* party = listDequeue(&parties);
+			if(party == NULL)
+			{
+				listEnqueue((void*)(uintptr_t)taxiId, &taxis);
+			}
+			else
+			{
+				checksum += (long long)taxiId * 31 + party->amount;
+				free(party);
+			}
+			++taxiId;
+		}
+		else if(taxis.head != NULL)
+		{
+			checksum += (long long)(int)(uintptr_t)listDequeue(&taxis) * 31 + (i & 7);
+		}
+		else
+		{
+			party_t* party = calloc(1, sizeof(party_t));
+			if(party == NULL)
+			{
+				printf("Failed to allocate new party\n");
+				exit(1);
+			}
+			party->amount = i & 7;
+			listEnqueue(party, &parties);
+		}
+	}
+
+	while(parties.head != NULL)
+	{
+		free(listDequeue(&parties));
+	}
+	while(taxis.head != NULL)
+	{
+		listDequeue(&taxis);
+	}
+	return checksum;
+}
+
+/*
+runRing: Replays the stream with the ring buffer queues from airportTaxi.c.
+@return: Checksum of all (taxi, party) matches
+*/
+long long runRing(const char* events, int numEvents)
+{
+	ringqueue_t parties = { NULL, sizeof(party_t), 0, 0, 0 };
+	ringqueue_t taxis = { NULL, sizeof(int), 0, 0, 0 };
+	long long checksum = 0;
+	int taxiId = 1;
+
+	for (int i = 0; i < numEvents; ++i)
+	{
+		if(events[i] == 0)
+		{
+			party_t party;
+			if(!dequeue(&party, &parties))
+			{
+				enqueue(&taxiId, &taxis);
+			}
+			else
+			{
+				checksum += (long long)taxiId * 31 + party.amount;
+			}
+			++taxiId;
+		}
+		else
+		{
+			int queuedTaxi;
+			if(dequeue(&queuedTaxi, &taxis))
+			{
+				checksum += (long long)queuedTaxi * 31 + (i & 7);
+			}
+			else
+			{
+				party_t party = { 0 };
+				party.amount = i & 7;
+				enqueue(&party, &parties);
+			}
+		}
+	}
+
+	freeAll(&parties);
+	freeAll(&taxis);
+	return checksum;
+}
+
+int main(int argc, char* argv[])
+{
+	int numEvents = (argc > 1) ? atoi(argv[1]) : 10000000;
+	char* events = malloc(numEvents);
+	if(events == NULL)
+	{
+		printf("Failed to allocate event stream\n");
+		exit(1);
+	}
+	generateEvents(events, numEvents);
+
+	struct timespec start, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	long long listChecksum = runList(events, numEvents);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double listTime = elapsedSeconds(start, end);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	long long ringChecksum = runRing(events, numEvents);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double ringTime = elapsedSeconds(start, end);
+
+	printf("Events: %d\n", numEvents);
+	printf("linkedlist_t: %.3f s (%.1f M events/s)\n", listTime, numEvents / listTime / 1e6);
+	printf("ringqueue_t:  %.3f s (%.1f M events/s)\n", ringTime, numEvents / ringTime / 1e6);
+	printf("Checksums %s\n", (listChecksum == ringChecksum) ? "match" : "DIFFER");
+
+	free(events);
+	return (listChecksum == ringChecksum) ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+/*
+	Airport Taxi Dispatcher Scaling Benchmark
+	Several kiosk/gate threads submit a shared stream of Taxi/Party arrivals
+	to the lock-free dispatcher in airportTaxi.c and report matches/sec for
+	1, 2, 4, ... up to the requested number of threads.
+
+	Build: gcc -O2 -pthread -o airportTaxiScaling airportTaxiScaling.c
+	Usage: ./airportTaxiScaling [maxThreads] [numEvents]
+*/
+
+#define main airportTaxiMain
+#include "airportTaxi.c"
+#undef main
+
+#include <pthread.h>
+#include <time.h>
+
+/* Work handed to one producer thread */
+typedef struct _worker
+{
+	pthread_t thread;
+	dispatcher_t* dispatcher;
+	const char* events; /* Taxi(0)/Party(1) stream shared by all threads */
+	int numEvents;
+	int threadIndex;
+	int numThreads;
+	long matches; /* Matches made by this thread */
+} worker_t;
+
+/*
+elapsedSeconds: Returns the seconds elapsed between two timestamps.
+@param start: The earlier timestamp
+@param end: The later timestamp
+@return: Elapsed time in seconds
+*/
+double elapsedSeconds(struct timespec start, struct timespec end)
+{
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/*
+runWorker: Submits every numThreads-th event of the stream to the dispatcher.
+@param _arg: Pointer to the worker
+*/
+void* runWorker(void* _arg)
+{
+	worker_t* worker = _arg;
+	arrival_t match;
+	char name[] = "Party";
+	long matches = 0;
+
+	for (int i = worker->threadIndex; i < worker->numEvents; i += worker->numThreads)
+	{
+		if(worker->events[i] == 0)
+		{
+			matches += concurrentTaxiArrival(worker->dispatcher, &match);
+		}
+		else
+		{
+			matches += concurrentPartyArrival(worker->dispatcher, 1 + (i & 3), name, &match);
+		}
+	}
+	worker->matches = matches;
+	return NULL;
+}
+
+int main(int argc, char* argv[])
+{
+	int maxThreads = (argc > 1) ? atoi(argv[1]) : 8;
+	int numEvents = (argc > 2) ? atoi(argv[2]) : 4000000;
+
+	/* Balanced random stream, so queues stay short and most arrivals match */
+	char* events = malloc(numEvents);
+	worker_t* workers = calloc(maxThreads, sizeof(worker_t));
+	if(events == NULL || workers == NULL)
+	{
+		printf("Failed to allocate benchmark state\n");
+		exit(1);
+	}
+	unsigned int seed = 12345;
+	int numParties = 0;
+	for (int i = 0; i < numEvents; ++i)
+	{
+		seed = seed * 1103515245u + 12345u;
+		events[i] = (seed >> 16) & 1;
+		numParties += events[i];
+	}
+
+	printf("Events: %d\n", numEvents);
+	for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+	{
+		dispatcher_t dispatcher;
+		initDispatcher(&dispatcher, numEvents); /* Never full, measures matching only */
+
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int t = 0; t < numThreads; ++t)
+		{
+			workers[t] = (worker_t){ 0, &dispatcher, events, numEvents, t, numThreads, 0 };
+			pthread_create(&workers[t].thread, NULL, runWorker, &workers[t]);
+		}
+
+		long matches = 0;
+		for (int t = 0; t < numThreads; ++t)
+		{
+			pthread_join(workers[t].thread, NULL);
+			matches += workers[t].matches;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		double seconds = elapsedSeconds(start, end);
+
+		/* Every party is either served or still in line, the same holds for taxis */
+		long balance = atomic_load(&dispatcher.balance);
+		int consistent = (matches == atomic_load(&dispatcher.servedGroups)) &&
+			(balance == (long)numParties - (numEvents - numParties));
+
+		printf("%2d threads: %ld matches in %.3f s (%.2f M matches/s)%s\n",
+			numThreads, matches, seconds, matches / seconds / 1e6,
+			consistent ? "" : " INCONSISTENT");
+		freeDispatcher(&dispatcher);
+	}
+
+	free(workers);
+	free(events);
+	return 0;
+}
@@ -5,237 +5,1007 @@
  * 
  *  Created  by Pasin Manurangsi, 2025-01-08
  *  Modified by Luka Bond, 2025-02-03
+ *
+ *  Usage: ./matrilineal [--threads n] < input  (Lineage walks wide generations on n threads)
  */
 
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-#define MAX_CHILDREN 10
+#define NAME_LENGTH 21 /* Names are cut to 20 characters */
+#define ARENA_INITIAL_CAPACITY 64
+#define INDEX_INITIAL_SIZE 64 /* Must be a power of two */
+#define NO_NODE -1
+#define MAX_BFS_THREADS 64
+#define PARALLEL_MIN_LEVEL 4096 /* Narrower generations are walked by a single thread */
+#define SNAPSHOT_MAGIC "MATRIL02" /* First 8 bytes of a snapshot file */
+
+void detachSnapshot();
+#define POOL_BEFORE_GROW() detachSnapshot() /* The pool never grows inside a mapped snapshot */
+#include "../../Common/stringPool.h"
 
 /* --------------- Data structures --------------- */
 
-/* Singly linked list node */
-typedef struct _llnode
+/* Struct-of-arrays node arena, a person is the same index in every array (Root is 0).
+   Indices stay valid when the arrays grow, sisters are linked in the order they were added. */
+typedef struct _tree
 {
-	void* data;
-	struct _llnode* nextNode;
-} llnode_t;
+	int* nameIds; /* Interned names, see stringpool_t */
+	int* parent; /* NO_NODE for the root */
+	int* firstChild; /* NO_NODE when there are no daughters */
+	int* lastChild; /* Appending a daughter is O(1) */
+	int* nextSibling; /* NO_NODE for the youngest daughter */
+	int* depth; /* Generations below the root */
+	int count;
+	int capacity;
+} tree_t;
 
-/* Linked List */
-typedef struct _linkedlist
+/* Name id to node index, NO_NODE for names nobody in the tree has */
+typedef struct _nameindex
 {
-	llnode_t* head;
-	llnode_t* tail;
-} linkedlist_t;
+	int* nodes;
+	int capacity;
+} nameindex_t;
 
-/* Custom tree node */
-typedef struct _tnode
+/* Reusable Breadth-First frontier. A traversal appends every visited node to the buffer,
+   so the buffer is both the queue and the result in Breadth-First order. */
+typedef struct _frontier
 {
-	char name[25];
-	struct _tnode* parent; /* The parent of the node */
-	struct _tnode* children; /* Pointer to an array of children */
-	int numChildren;
-	int maxChildren; 
-} tnode_t;
+	int* nodes;
+	int count; /* Nodes visited by the last traversal */
+	int capacity;
+} frontier_t;
+
+/* State shared by the threads of one level-synchronous traversal.
+   Generations sit back to back in the frontier, a thread expands its slice of the
+   current generation into the slice of the next one given by the prefix sums. */
+typedef struct _parallelbfs
+{
+	frontier_t* frontier;
+	int nameId; /* NO_NODE to visit every node */
+	int numThreads;
+	int levelStart; /* Current generation is nodes[levelStart, levelEnd) */
+	int levelEnd;
+	int nextEnd; /* End of the generation being built */
+	int match; /* Frontier position of the first match, -1 if none */
+	int done;
+	int childCounts[MAX_BFS_THREADS]; /* Daughters per slice, then where the slice writes them */
+	int matches[MAX_BFS_THREADS]; /* First match per slice, INT_MAX if none */
+	pthread_barrier_t barrier;
+} parallelbfs_t;
+
+/* One thread of a level-synchronous traversal */
+typedef struct _bfsworker
+{
+	pthread_t thread;
+	parallelbfs_t* shared;
+	int index;
+} bfsworker_t;
+
+/* Snapshot file header. The header is followed by the string arena (Padded to a
+   multiple of 8 bytes), the offsets and hashes (stringCount ints each), the string
+   table (tableSize ints), the name index (stringCount ints) and finally nameIds,
+   parent, firstChild, lastChild, nextSibling and depth (count ints each). */
+typedef struct _snapshotheader
+{
+	char magic[8];
+	int count; /* Nodes in the tree */
+	int stringCount; /* Distinct names */
+	int arenaSize; /* Bytes of the string arena */
+	int tableSize; /* Cells in the string table */
+} snapshotheader_t;
 
 /* --------------- Global variables --------------- */
 
-tnode_t treeRoot = { "", NULL, NULL, 0, MAX_CHILDREN };
+tree_t tree = { NULL, NULL, NULL, NULL, NULL, NULL, 0, 0 };
+nameindex_t nameIndex = { NULL, 0 }; /* Every person in the tree by name */
+frontier_t frontier = { NULL, 0, 0 }; /* Shared by the traversals, only grows with the tree */
+void* snapshot = NULL; /* Mapped snapshot the tree, names and index point into, NULL once on the heap */
+size_t snapshotSize = 0;
+
+/* --------------- Memory-mapped snapshot --------------- */
+
+/* 
+snapshotArenaSize: Returns the bytes taken by the string arena section of a snapshot.
+@param arenaSize: The bytes used by the string arena
+@return: Size of the section, padded to a multiple of 8 bytes
+*/
+size_t snapshotArenaSize(int arenaSize)
+{
+	return ((size_t)arenaSize + 7) & ~(size_t)7;
+}
+
+/* 
+saveSnapshot: Writes the tree, the string pool and the name index to a snapshot file.
+@param path: The path of the file
+*/
+void saveSnapshot(char* path)
+{
+	FILE* file = fopen(path, "wb");
+	if(file == NULL)
+	{
+		printf("Failed to open snapshot\n");
+		exit(1);
+	}
+
+	snapshotheader_t header = { SNAPSHOT_MAGIC, tree.count, strings.count, strings.arenaSize, strings.size };
+	char padding[8] = { 0 };
+	size_t paddingSize = snapshotArenaSize(strings.arenaSize) - strings.arenaSize;
+	size_t count = tree.count;
+	size_t stringCount = strings.count;
+	int written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(strings.arena, 1, strings.arenaSize, file) == (size_t)strings.arenaSize &&
+		fwrite(padding, 1, paddingSize, file) == paddingSize &&
+		fwrite(strings.offsets, sizeof(int), stringCount, file) == stringCount &&
+		fwrite(strings.hashes, sizeof(int), stringCount, file) == stringCount &&
+		fwrite(strings.table, sizeof(int), strings.size, file) == (size_t)strings.size &&
+		fwrite(nameIndex.nodes, sizeof(int), stringCount, file) == stringCount &&
+		fwrite(tree.nameIds, sizeof(int), count, file) == count &&
+		fwrite(tree.parent, sizeof(int), count, file) == count &&
+		fwrite(tree.firstChild, sizeof(int), count, file) == count &&
+		fwrite(tree.lastChild, sizeof(int), count, file) == count &&
+		fwrite(tree.nextSibling, sizeof(int), count, file) == count &&
+		fwrite(tree.depth, sizeof(int), count, file) == count;
+	if(fclose(file) != 0 || !written)
+	{
+		printf("Failed to write snapshot\n");
+		exit(1);
+	}
+}
+
+/* 
+allInRange: Checks that every value of an array lies in [low, high).
+@param _array: Pointer to the array
+@param length: The number of values
+@param low: The smallest valid value
+@param high: One past the largest valid value
+@return: 1 if every value is in range, 0 otherwise
+*/
+int allInRange(int* _array, size_t length, int low, int high)
+{
+	for (size_t i = 0; i < length; ++i)
+	{
+		if(_array[i] < low || _array[i] >= high)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* 
+validSnapshot: Checks the sections of a freshly mapped snapshot before anything follows
+	an id, offset or link out of them, so a corrupted file cannot send a lookup out of
+	bounds or a traversal round a cycle. Reads every page of the mapping once.
+@return: 1 if the snapshot is well-formed, 0 otherwise
+*/
+int validSnapshot()
+{
+	int count = tree.count;
+	int stringCount = strings.count;
+	if(strings.arena[strings.arenaSize - 1] != '\0' || /* So every name ends inside the arena */
+		!allInRange(strings.offsets, stringCount, 0, strings.arenaSize) ||
+		!allInRange(strings.table, strings.size, NO_NODE, stringCount) ||
+		!allInRange(nameIndex.nodes, stringCount, NO_NODE, count) ||
+		!allInRange(tree.nameIds, count, 0, stringCount) ||
+		!allInRange(tree.parent, count, NO_NODE, count) ||
+		!allInRange(tree.firstChild, count, NO_NODE, count) ||
+		!allInRange(tree.lastChild, count, NO_NODE, count) ||
+		!allInRange(tree.nextSibling, count, NO_NODE, count) ||
+		!allInRange(tree.depth, count, 0, count))
+	{
+		return 0;
+	}
+
+	/* Each name sits in the table once, the free cells end every probe */
+	int usedCells = 0;
+	for (int i = 0; i < strings.size; ++i)
+	{
+		usedCells += (strings.table[i] != NO_NODE);
+	}
+	if(usedCells != stringCount)
+	{
+		return 0;
+	}
+	for (int i = 0; i < stringCount; ++i)
+	{
+		if(nameIndex.nodes[i] != NO_NODE && tree.nameIds[nameIndex.nodes[i]] != i)
+		{
+			return 0;
+		}
+	}
+
+	/* Depths rule out cycles through the mothers, only the root has none */
+	if(tree.parent[0] != NO_NODE || tree.depth[0] != 0)
+	{
+		return 0;
+	}
+	for (int i = 1; i < count; ++i)
+	{
+		if(tree.parent[i] == NO_NODE || tree.depth[i] != tree.depth[tree.parent[i]] + 1)
+		{
+			return 0;
+		}
+	}
+
+	/* Every daughter list holds only her daughters, ends at lastChild and reaches everyone once */
+	int linked = 0;
+	for (int mother = 0; mother < count; ++mother)
+	{
+		int youngest = NO_NODE;
+		for (int child = tree.firstChild[mother]; child != NO_NODE; child = tree.nextSibling[child])
+		{
+			if(tree.parent[child] != mother || ++linked >= count)
+			{
+				return 0;
+			}
+			youngest = child;
+		}
+		if(tree.lastChild[mother] != youngest)
+		{
+			return 0;
+		}
+	}
+	return linked == count - 1;
+}
+
+/* 
+loadSnapshot: Maps a snapshot file and points the tree, the string pool and the name
+	index straight into it. Nothing is parsed or copied, the sections are only validated.
+	The mapping is read-only: the snapshot is loaded at full capacity, so the first Add
+	grows an array and detaches everything onto the heap before anything is written.
+@param path: The path of the file
+*/
+void loadSnapshot(char* path)
+{
+	int fd = open(path, O_RDONLY);
+	struct stat info;
+	if(fd < 0 || fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(snapshotheader_t))
+	{
+		printf("Failed to open snapshot\n");
+		exit(1);
+	}
+	char* base = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(base == MAP_FAILED)
+	{
+		printf("Failed to map snapshot\n");
+		exit(1);
+	}
+
+	snapshotheader_t* header = (snapshotheader_t*)base;
+	int count = header->count;
+	int stringCount = header->stringCount;
+	size_t expectedSize = sizeof(snapshotheader_t) + snapshotArenaSize(header->arenaSize) +
+		(3 * (size_t)stringCount + header->tableSize + 6 * (size_t)count) * sizeof(int);
+	int tableSize = header->tableSize;
+	if(memcmp(header->magic, SNAPSHOT_MAGIC, 8) != 0 || count <= 0 || stringCount <= 0 ||
+		header->arenaSize <= 0 || tableSize <= stringCount || (tableSize & (tableSize - 1)) != 0 ||
+		expectedSize != (size_t)info.st_size)
+	{
+		printf("Invalid snapshot\n");
+		exit(1);
+	}
+
+	char* section = base + sizeof(snapshotheader_t);
+	strings.arena = section;
+	int* arrays = (int*)(section + snapshotArenaSize(header->arenaSize));
+	strings.offsets = arrays;
+	strings.hashes = (unsigned int*)(arrays + stringCount);
+	strings.table = arrays + 2 * (size_t)stringCount;
+	strings.count = stringCount;
+	strings.capacity = stringCount;
+	strings.arenaSize = header->arenaSize;
+	strings.arenaCapacity = header->arenaSize;
+	strings.size = header->tableSize;
 
-/* --------------- Linked list-based Queue implementation --------------- */
+	arrays += 2 * (size_t)stringCount + header->tableSize;
+	nameIndex.nodes = arrays;
+	nameIndex.capacity = stringCount;
+
+	arrays += stringCount;
+	tree.nameIds = arrays;
+	tree.parent = arrays + count;
+	tree.firstChild = arrays + 2 * (size_t)count;
+	tree.lastChild = arrays + 3 * (size_t)count;
+	tree.nextSibling = arrays + 4 * (size_t)count;
+	tree.depth = arrays + 5 * (size_t)count;
+	tree.count = count;
+	tree.capacity = count;
+	if(!validSnapshot())
+	{
+		printf("Invalid snapshot\n");
+		exit(1);
+	}
+
+	snapshot = base;
+	snapshotSize = info.st_size;
+}
 
 /* 
-Enqueue: Add data (of any type) to a specified queue.
-@param _data: Pointer to data (of any type) to be stored
-@param _queue: Pointer to the queue
+copyOut: Copies an array out of the snapshot onto the heap.
+@param _array: Pointer to the array
+@param size: Size of the array in bytes
+@return: Pointer to the copy
 */
-void enqueue(void* _data, linkedlist_t* _queue)
+void* copyOut(void* _array, size_t size)
 {
-	llnode_t* newNode = calloc(1, sizeof(llnode_t));
-	if(newNode == NULL)
+	void* copy = malloc(size);
+	if(copy == NULL)
 	{
-		printf("Failed to allocate new node\n");
+		printf("Failed to copy snapshot\n");
 		exit(1);
 	}
+	memcpy(copy, _array, size);
+	return copy;
+}
+
+/* 
+detachSnapshot: Moves the tree, the string pool and the name index from the snapshot
+	onto the heap and unmaps it, so they can grow. Does nothing when no snapshot is mapped.
+*/
+void detachSnapshot()
+{
+	if(snapshot == NULL)
+	{
+		return;
+	}
+
+	size_t arraySize = (size_t)tree.count * sizeof(int);
+	size_t stringsSize = (size_t)strings.count * sizeof(int);
+	tree.nameIds = copyOut(tree.nameIds, arraySize);
+	tree.parent = copyOut(tree.parent, arraySize);
+	tree.firstChild = copyOut(tree.firstChild, arraySize);
+	tree.lastChild = copyOut(tree.lastChild, arraySize);
+	tree.nextSibling = copyOut(tree.nextSibling, arraySize);
+	tree.depth = copyOut(tree.depth, arraySize);
+	strings.arena = copyOut(strings.arena, strings.arenaSize);
+	strings.offsets = copyOut(strings.offsets, stringsSize);
+	strings.hashes = copyOut(strings.hashes, stringsSize);
+	strings.table = copyOut(strings.table, (size_t)strings.size * sizeof(int));
+	nameIndex.nodes = copyOut(nameIndex.nodes, stringsSize);
 
-	/* Filling node attributes */
-	newNode->data = _data; /* Fill data */
-	newNode->nextNode = NULL; /* No next node (new tail) */
-	
-	if(_queue->tail != NULL)
+	munmap(snapshot, snapshotSize);
+	snapshot = NULL;
+	snapshotSize = 0;
+}
+
+/* ---------- Name index - One cell per name id ---------- */
+
+/* 
+BFBefore: Tells whether a node comes before another in Breadth-First order.
+	Used to resolve duplicate names the same way BFSearch would.
+@param _first: Index of the first node
+@param _second: Index of the second node
+@return: 1 if the first node is visited earlier, 0 otherwise
+*/
+int BFBefore(int _first, int _second)
+{
+	if(tree.depth[_first] != tree.depth[_second])
 	{
-		/* Next node of current tail is the new node */
-		(_queue->tail)->nextNode = newNode;
+		return tree.depth[_first] < tree.depth[_second]; /* Shallower generations come first */
 	}
 
-	/* Queue is empty */
-	if(_queue->head == NULL)
+	/* Climb to the children of the closest common ancestor */
+	while(tree.parent[_first] != tree.parent[_second])
 	{
-		_queue->head = newNode;
+		_first = tree.parent[_first];
+		_second = tree.parent[_second];
 	}
-	_queue->tail = newNode; /* Reassigning the tail*/
+	return _first < _second; /* Sisters get increasing indices in the order they were added */
 }
 
 /* 
-Dequeue: Remove data (of any type) from a specified queue.
-@param _queue: Pointer to the queue
-@return: Pointer to the allocated data
+reserveIndex: Grows the name index to one cell per name in the string pool.
 */
-void* dequeue(linkedlist_t* _queue)
-{	
-	if(_queue->head == NULL)
+void reserveIndex()
+{
+	if(nameIndex.capacity >= strings.count)
+	{
+		return;
+	}
+
+	detachSnapshot();
+	int capacity = strings.capacity;
+	nameIndex.nodes = growArray(nameIndex.nodes, sizeof(int), capacity);
+	for (int id = nameIndex.capacity; id < capacity; ++id)
 	{
-		return NULL;
+		nameIndex.nodes[id] = NO_NODE;
 	}
+	nameIndex.capacity = capacity;
+}
 
-	llnode_t* prevHead = _queue->head;
-	void* item = (_queue->head)->data;
-	
-	/* Reassign new head */
-	_queue->head = (_queue->head)->nextNode;
-	if(_queue->head == NULL)
+/* 
+indexSearch: Search for a person in the name index.
+@param _name: The name to search for
+@return: Index of the matching node (First in Breadth-First order), NO_NODE if not found
+*/
+int indexSearch(char* _name)
+{
+	int id = findString(_name);
+	if(id == NO_NODE || id >= nameIndex.capacity)
 	{
-		/* If the new head is null, tail must also be null */
-		_queue->tail = NULL;
+		return NO_NODE;
 	}
+	return nameIndex.nodes[id];
+}
 
-	/* Free and set old pointer to NULL*/
-	free(prevHead);
-	prevHead = NULL;
+/* 
+indexInsert: Add a node to the name index. If the name is already taken, the
+	index keeps whichever node Breadth-First Search would find first.
+@param _node: Index of the node
+*/
+void indexInsert(int _node)
+{
+	reserveIndex();
+	int id = tree.nameIds[_node];
+	if(nameIndex.nodes[id] == NO_NODE || BFBefore(_node, nameIndex.nodes[id]))
+	{
+		nameIndex.nodes[id] = _node;
+	}
+}
 
-	return item;
+/* 
+indexAppend: Add a node that comes after every indexed node in Breadth-First order,
+	skipping the order check of indexInsert.
+@param _node: Index of the node
+*/
+void indexAppend(int _node)
+{
+	reserveIndex();
+	int id = tree.nameIds[_node];
+	if(nameIndex.nodes[id] == NO_NODE)
+	{
+		nameIndex.nodes[id] = _node;
+	}
 }
 
+/* --------------- Struct-of-arrays Tree implementation --------------- */
+
 /* 
-front: Return data (of any type) from the front of the queue.
-@param _queue: Pointer to the queue
-@return: Pointer to the allocated data
+newNode: Appends a person without relations to the arena, growing it when full.
+@param _nameId: The interned name to be stored in the node
+@return: Index of the new node
 */
-void* front(linkedlist_t* _queue)
-{	
-	if(_queue->head == NULL)
+int newNode(int _nameId)
+{
+	if(tree.count == tree.capacity)
 	{
-		return NULL;
+		detachSnapshot();
+		tree.capacity = (tree.capacity == 0) ? ARENA_INITIAL_CAPACITY : tree.capacity * 2;
+		tree.nameIds = growArray(tree.nameIds, sizeof(int), tree.capacity);
+		tree.parent = growArray(tree.parent, sizeof(int), tree.capacity);
+		tree.firstChild = growArray(tree.firstChild, sizeof(int), tree.capacity);
+		tree.lastChild = growArray(tree.lastChild, sizeof(int), tree.capacity);
+		tree.nextSibling = growArray(tree.nextSibling, sizeof(int), tree.capacity);
+		tree.depth = growArray(tree.depth, sizeof(int), tree.capacity);
 	}
-	return (_queue->head)->data;
+
+	int node = tree.count++;
+	tree.nameIds[node] = _nameId;
+	tree.parent[node] = NO_NODE;
+	tree.firstChild[node] = NO_NODE;
+	tree.lastChild[node] = NO_NODE;
+	tree.nextSibling[node] = NO_NODE;
+	tree.depth[node] = 0;
+	return node;
 }
 
-/* --------------- Custom array-based Tree implementation --------------- */
+/* 
+linkChild: Add a new child node to the specified parent node in the tree, without indexing its name
+@param _parent: Index of the parent node
+@param _nameId: The interned name to be stored in the child node
+@return: Index of the child node
+*/
+int linkChild(int _parent, int _nameId)
+{
+	int _child = newNode(_nameId);
+	tree.parent[_child] = _parent;
+	tree.depth[_child] = tree.depth[_parent] + 1;
+
+	/* Link the child after the youngest sister */
+	if(tree.lastChild[_parent] == NO_NODE)
+	{
+		tree.firstChild[_parent] = _child;
+	}
+	else
+	{
+		tree.nextSibling[tree.lastChild[_parent]] = _child;
+	}
+	tree.lastChild[_parent] = _child;
+	return _child;
+}
 
 /* 
 insertChild: Add a new child node to the specified parent node in the tree
-@param _parent: Pointer to the parent node
+@param _parent: Index of the parent node
 @param _name: The string to be sotred in the child node
+@return: Index of the child node
+*/
+int insertChild(int _parent, char* _name)
+{
+	int _child = linkChild(_parent, internString(_name));
+	indexInsert(_child);
+	return _child;
+}
+
+/* 
+reserveFrontier: Grows the frontier so it can hold every node of the tree.
+	Does nothing once the frontier has caught up with the tree.
+@param _frontier: Pointer to the frontier
 */
-void insertChild(tnode_t* _parent, char* _name)
+void reserveFrontier(frontier_t* _frontier)
 {
-	/* There can be no more than the max amount of children */
-	if(_parent->numChildren == _parent->maxChildren)
+	if(_frontier->capacity >= tree.count)
 	{
-		printf("Cannot add more children to the current parent node\n");
 		return;
 	}
 
-	/* If the parent is pointing to no children (NULL), create a new array of children */
-	if(_parent->children == NULL)
+	int* newNodes = realloc(_frontier->nodes, tree.capacity * sizeof(int));
+	if(newNodes == NULL)
 	{
-		/* Number of children will follow the max amount children from root */
-		tnode_t* _children = calloc(_parent->maxChildren, sizeof(tnode_t));
-		if(_children == NULL)
-		{
-			printf("Failed to allocate new array of tree nodes\n");
-			exit(1);
-		}
-		_parent->children = _children; /* Reassign children pointer */
+		printf("Failed to allocate frontier\n");
+		exit(1);
 	}
-	++_parent->numChildren; 
+	_frontier->nodes = newNodes;
+	_frontier->capacity = tree.capacity;
+}
 
-	/* Access the child at the back of the array */
-	tnode_t* _child = &_parent->children[_parent->numChildren - 1];\
-	strncpy(_child->name, _name, 20);
-	_child->parent = _parent;
-	_child->children = NULL; /* New node = no children */
-	_child->numChildren = 0; 
-	_child->maxChildren = _parent->maxChildren; /* Inherit from parent */
+/* 
+freeFrontier: Free the buffer of a frontier.
+@param _frontier: Pointer to the frontier
+*/
+void freeFrontier(frontier_t* _frontier)
+{
+	free(_frontier->nodes);
+	_frontier->nodes = NULL;
+	_frontier->count = 0;
+	_frontier->capacity = 0;
 }
 
 /* 
-BFPrint: Print the string in every node in the tree/subtree using Breadth-First Traversal
-@param _root: Pointer to the root node of the tree/subtree
+BFTraverse: Visit the nodes of the tree/subtree using Breadth-First Traversal,
+	stopping at the first node with a matching name.
+@param _root: Index of the root node of the tree/subtree
+@param _nameId: The name id to stop at, NO_NODE to visit every node
+@param _frontier: Pointer to the frontier, holds the visited nodes in order afterwards
+@return: Index of the first matching node, NO_NODE if not found
 */
-void BFPrint(tnode_t* _root)
+int BFTraverse(int _root, int _nameId, frontier_t* _frontier)
 {
-	linkedlist_t _queue = { NULL, NULL };
-	enqueue(_root, &_queue); /* Store root node in queue */
+	reserveFrontier(_frontier);
+	int* nodes = _frontier->nodes;
+	int head = 0;
+	int tail = 0;
+	nodes[tail++] = _root; /* Store root node in queue */
 
 	/* While queue is not empty */
-	while(front(&_queue) != NULL)
+	while(head < tail)
 	{
-		tnode_t* frontNode = dequeue(&_queue);
-		printf("%s ", frontNode->name);
-		for (int i = 0; i < frontNode->numChildren; ++i)
+		int frontNode = nodes[head++];
+		if(tree.nameIds[frontNode] == _nameId)
+		{
+			/* Return node with the matching name */
+			_frontier->count = head;
+			return frontNode;
+		}
+
+		for (int child = tree.firstChild[frontNode]; child != NO_NODE; child = tree.nextSibling[child])
 		{
 			/* Store children node in queue */
-			enqueue(&frontNode->children[i], &_queue); 
+			nodes[tail++] = child;
 		}
 	}
+	_frontier->count = tail;
+	return NO_NODE;
+}
+
+/* 
+BFPrint: Print the string in every node in the tree/subtree using Breadth-First Traversal
+@param _root: Index of the root node of the tree/subtree
+@param _frontier: Pointer to the frontier used for the traversal
+*/
+void BFPrint(int _root, frontier_t* _frontier)
+{
+	BFTraverse(_root, NO_NODE, _frontier);
+	for (int i = 0; i < _frontier->count; ++i)
+	{
+		printf("%s ", stringOf(tree.nameIds[_frontier->nodes[i]]));
+	}
 	printf("\n");
 }
 
 /* 
 BFSearch: Search for the node name in every node in the 
 		tree/subtree using Breadth-First Traversal
-@param _root: Pointer to the root node of the tree/subtree
+@param _root: Index of the root node of the tree/subtree
 @param _name: The name to search for in the tree/subtree
-@return: Pointer to the first matching node
+@param _frontier: Pointer to the frontier used for the traversal
+@return: Index of the first matching node, NO_NODE if not found
 */
-tnode_t* BFSearch(tnode_t* _root, char* _name)
+int BFSearch(int _root, char* _name, frontier_t* _frontier)
 {
-	linkedlist_t _queue = { NULL, NULL };
-	enqueue(_root, &_queue); /* Store root node in queue */
+	int nameId = findString(_name);
+	if(nameId == NO_NODE)
+	{
+		_frontier->count = 0; /* Nobody was ever given the name, nothing to walk */
+		return NO_NODE;
+	}
+	return BFTraverse(_root, nameId, _frontier);
+}
 
-	/* While queue is not empty */
-	while(front(&_queue) != NULL)
+/* 
+freeTree: Free every array of the node arena.
+*/
+void freeTree()
+{
+	if(snapshot != NULL)
+	{
+		/* The string pool and the name index live in the snapshot too */
+		munmap(snapshot, snapshotSize);
+		snapshot = NULL;
+		memset(&tree, 0, sizeof(tree_t));
+		memset(&strings, 0, sizeof(stringpool_t));
+		memset(&nameIndex, 0, sizeof(nameindex_t));
+		return;
+	}
+	free(tree.nameIds);
+	free(tree.parent);
+	free(tree.firstChild);
+	free(tree.lastChild);
+	free(tree.nextSibling);
+	free(tree.depth);
+	memset(&tree, 0, sizeof(tree_t));
+}
+
+/* --------------- Level-synchronous parallel traversal --------------- */
+
+/* 
+expandLevels: Moves on to the generation built last and walks it, and any
+	following generation narrower than PARALLEL_MIN_LEVEL, on the calling thread.
+	Only ever called by a single thread between two barriers.
+@param _bfs: Pointer to the shared traversal state
+*/
+void expandLevels(parallelbfs_t* _bfs)
+{
+	int* nodes = _bfs->frontier->nodes;
+	_bfs->levelStart = _bfs->levelEnd;
+	_bfs->levelEnd = _bfs->nextEnd;
+
+	while(_bfs->levelStart < _bfs->levelEnd && _bfs->levelEnd - _bfs->levelStart < PARALLEL_MIN_LEVEL)
 	{
-		tnode_t* frontNode = dequeue(&_queue);
-		if(!strcmp(frontNode->name, _name))
+		for (int i = _bfs->levelStart; i < _bfs->levelEnd; ++i)
 		{
-			/* Return node with the matching name */
-			return frontNode; 
+			if(tree.nameIds[nodes[i]] == _bfs->nameId)
+			{
+				_bfs->match = i;
+				_bfs->done = 1;
+				return;
+			}
+			for (int child = tree.firstChild[nodes[i]]; child != NO_NODE; child = tree.nextSibling[child])
+			{
+				nodes[_bfs->nextEnd++] = child;
+			}
 		}
+		_bfs->levelStart = _bfs->levelEnd;
+		_bfs->levelEnd = _bfs->nextEnd;
+	}
+
+	if(_bfs->levelStart == _bfs->levelEnd)
+	{
+		_bfs->done = 1; /* No more generations */
+	}
+}
 
-		for (int i = 0; i < frontNode->numChildren; ++i)
+/* 
+combineSlices: Picks the leftmost match of the generation, or turns the daughter
+	counts of every slice into write positions in the next generation.
+	Only ever called by a single thread between two barriers.
+@param _bfs: Pointer to the shared traversal state
+*/
+void combineSlices(parallelbfs_t* _bfs)
+{
+	for (int t = 0; t < _bfs->numThreads; ++t)
+	{
+		if(_bfs->matches[t] != INT_MAX)
 		{
-			/* Store children node in queue */
-			enqueue(&frontNode->children[i], &_queue); 
+			_bfs->match = _bfs->matches[t]; /* Slices are in order, the first hit is the leftmost */
+			_bfs->done = 1;
+			return;
+		}
+	}
+
+	int offset = _bfs->levelEnd;
+	for (int t = 0; t < _bfs->numThreads; ++t)
+	{
+		int count = _bfs->childCounts[t];
+		_bfs->childCounts[t] = offset;
+		offset += count;
+	}
+	_bfs->nextEnd = offset;
+}
+
+/* 
+runBFSWorker: Thread body of a level-synchronous traversal. Every generation takes
+	a search/count pass and a write pass over the thread's slice, separated by barriers.
+@param _arg: Pointer to the worker
+*/
+void* runBFSWorker(void* _arg)
+{
+	bfsworker_t* worker = _arg;
+	parallelbfs_t* bfs = worker->shared;
+	int* nodes = bfs->frontier->nodes;
+	int t = worker->index;
+
+	for (;;)
+	{
+		if(pthread_barrier_wait(&bfs->barrier) == PTHREAD_BARRIER_SERIAL_THREAD)
+		{
+			expandLevels(bfs);
+		}
+		pthread_barrier_wait(&bfs->barrier);
+		if(bfs->done) break;
+
+		/* Slice of the current generation owned by this thread */
+		long width = bfs->levelEnd - bfs->levelStart;
+		int start = bfs->levelStart + (int)(width * t / bfs->numThreads);
+		int end = bfs->levelStart + (int)(width * (t + 1) / bfs->numThreads);
+
+		int count = 0;
+		bfs->matches[t] = INT_MAX;
+		for (int i = start; i < end; ++i)
+		{
+			if(tree.nameIds[nodes[i]] == bfs->nameId)
+			{
+				bfs->matches[t] = i; /* Nothing past the first match in the slice matters */
+				break;
+			}
+			for (int child = tree.firstChild[nodes[i]]; child != NO_NODE; child = tree.nextSibling[child])
+			{
+				++count;
+			}
+		}
+		bfs->childCounts[t] = count;
+
+		if(pthread_barrier_wait(&bfs->barrier) == PTHREAD_BARRIER_SERIAL_THREAD)
+		{
+			combineSlices(bfs);
+		}
+		pthread_barrier_wait(&bfs->barrier);
+		if(bfs->done) break;
+
+		/* Daughters of the slice, in order, at the slice's position in the next generation */
+		int position = bfs->childCounts[t];
+		for (int i = start; i < end; ++i)
+		{
+			for (int child = tree.firstChild[nodes[i]]; child != NO_NODE; child = tree.nextSibling[child])
+			{
+				nodes[position++] = child;
+			}
 		}
 	}
 	return NULL;
 }
 
 /* 
-freeTree: Free all of the nodes from the tree/subtree 
-		using Depth-First Traversal (Recursion)
-@param _root: Pointer to the root node of the tree/subtree
+BFTraverseParallel: BFTraverse with every wide generation split across threads.
+	The frontier ends up exactly as BFTraverse would leave it.
+@param _root: Index of the root node of the tree/subtree
+@param _nameId: The name id to stop at, NO_NODE to visit every node
+@param _frontier: Pointer to the frontier, holds the visited nodes in order afterwards
+@param numThreads: The number of threads (At most MAX_BFS_THREADS)
+@return: Index of the first matching node, NO_NODE if not found
 */
-void freeTree(tnode_t* _root)
+int BFTraverseParallel(int _root, int _nameId, frontier_t* _frontier, int numThreads)
 {
-	/* No child encountered in the current node */
-	if(_root == NULL)
+	if(numThreads > MAX_BFS_THREADS) numThreads = MAX_BFS_THREADS;
+	if(numThreads <= 1)
 	{
-		return;
+		return BFTraverse(_root, _nameId, _frontier);
+	}
+
+	reserveFrontier(_frontier);
+	_frontier->nodes[0] = _root;
+
+	parallelbfs_t bfs;
+	bfs.frontier = _frontier;
+	bfs.nameId = _nameId;
+	bfs.numThreads = numThreads;
+	bfs.levelStart = 0;
+	bfs.levelEnd = 0;
+	bfs.nextEnd = 1; /* The root is the first generation */
+	bfs.match = -1;
+	bfs.done = 0;
+	pthread_barrier_init(&bfs.barrier, NULL, numThreads);
+
+	bfsworker_t workers[MAX_BFS_THREADS];
+	for (int t = 0; t < numThreads; ++t)
+	{
+		workers[t].shared = &bfs;
+		workers[t].index = t;
+		if(t > 0 && pthread_create(&workers[t].thread, NULL, runBFSWorker, &workers[t]) != 0)
+		{
+			printf("Failed to create traversal thread\n");
+			exit(1);
+		}
 	}
+	runBFSWorker(&workers[0]); /* The calling thread takes the first slice */
+	for (int t = 1; t < numThreads; ++t)
+	{
+		pthread_join(workers[t].thread, NULL);
+	}
+	pthread_barrier_destroy(&bfs.barrier);
+
+	if(bfs.match >= 0)
+	{
+		_frontier->count = bfs.match + 1;
+		return _frontier->nodes[bfs.match];
+	}
+	_frontier->count = bfs.levelEnd;
+	return NO_NODE;
+}
 
-	/* Exits loop if unable to explore deeper than the depth of all child nodes */
-	for (int i = 0; i < _root->numChildren; ++i)
+/* 
+BFPrintParallel: BFPrint using a parallel traversal, printed in the same order.
+@param _root: Index of the root node of the tree/subtree
+@param _frontier: Pointer to the frontier used for the traversal
+@param numThreads: The number of threads
+*/
+void BFPrintParallel(int _root, frontier_t* _frontier, int numThreads)
+{
+	BFTraverseParallel(_root, NO_NODE, _frontier, numThreads);
+	for (int i = 0; i < _frontier->count; ++i)
 	{
-		freeTree(&_root->children[i]);
+		printf("%s ", stringOf(tree.nameIds[_frontier->nodes[i]]));
 	}
+	printf("\n");
+}
 
-	/* Free the pointer to the array of children of the current subtree*/
-	free(_root->children);
-	_root->children = NULL;
+/* 
+BFSearchParallel: BFSearch using a parallel traversal, finds the same node.
+@param _root: Index of the root node of the tree/subtree
+@param _name: The name to search for in the tree/subtree
+@param _frontier: Pointer to the frontier used for the traversal
+@param numThreads: The number of threads
+@return: Index of the first matching node, NO_NODE if not found
+*/
+int BFSearchParallel(int _root, char* _name, frontier_t* _frontier, int numThreads)
+{
+	int nameId = findString(_name);
+	if(nameId == NO_NODE)
+	{
+		_frontier->count = 0;
+		return NO_NODE;
+	}
+	return BFTraverseParallel(_root, nameId, _frontier, numThreads);
+}
+
+/* --------------- Bulk out-of-order loader --------------- */
+
+/* 
+bulkLoad: Reads a whole lineage, the root followed by (name, mother) records in any
+	order, and builds the tree in a few linear passes instead of one search per record.
+	A mother's name refers to the first record with that name, sisters keep their file
+	order. Records that never connect to the root are counted as unsuccessful.
+@param numRecords: The number of records, the root included
+*/
+void bulkLoad(int numRecords)
+{
+	if(numRecords < 1) /* The root at least */
+	{
+		printf("Invalid number of records\n");
+		exit(1);
+	}
+
+	char name[25];
+	char motherName[25];
+	int* recordName = malloc(numRecords * sizeof(int));
+	int* recordMother = malloc(numRecords * sizeof(int)); /* Name id, then record index */
+	int* childStart = calloc(numRecords + 2, sizeof(int)); /* Daughters of record r are children[childStart[r], childStart[r + 1]) */
+	int* children = malloc(numRecords * sizeof(int));
+	if(recordName == NULL || recordMother == NULL || childStart == NULL || children == NULL)
+	{
+		printf("Failed to allocate bulk loader\n");
+		exit(1);
+	}
+
+	/* Size the tables for every record up front, so they never rehash */
+	int indexSize = INDEX_INITIAL_SIZE;
+	while(indexSize < 2 * numRecords)
+	{
+		indexSize *= 2;
+	}
+	resizeStrings(indexSize);
+
+	/* Pass 1: intern every name */
+	readName(name);
+	recordName[0] = internString(name);
+	recordMother[0] = NO_NODE;
+	for (int r = 1; r < numRecords; ++r)
+	{
+		readName(name);
+		readName(motherName);
+		recordName[r] = internString(name);
+		recordMother[r] = internString(motherName);
+	}
+
+	/* First record named after each string, NO_NODE if only seen as a mother */
+	int* firstRecord = malloc(strings.count * sizeof(int));
+	if(firstRecord == NULL)
+	{
+		printf("Failed to allocate bulk loader\n");
+		exit(1);
+	}
+	for (int id = 0; id < strings.count; ++id)
+	{
+		firstRecord[id] = NO_NODE;
+	}
+	for (int r = numRecords - 1; r >= 0; --r)
+	{
+		firstRecord[recordName[r]] = r;
+	}
+
+	/* Pass 2: resolve mothers and count daughters, shifted by two so that the
+	   prefix sums leave room for the write cursors of pass 3 */
+	for (int r = 1; r < numRecords; ++r)
+	{
+		recordMother[r] = firstRecord[recordMother[r]];
+		if(recordMother[r] != NO_NODE)
+		{
+			++childStart[recordMother[r] + 2];
+		}
+	}
+	for (int r = 2; r <= numRecords; ++r)
+	{
+		childStart[r] += childStart[r - 1];
+	}
+
+	/* Pass 3: stable counting sort of the records by mother (Compressed children layout).
+	   childStart[m + 1] is the write cursor of mother m and ends at the start of m + 1 */
+	for (int r = 1; r < numRecords; ++r)
+	{
+		if(recordMother[r] != NO_NODE)
+		{
+			children[childStart[recordMother[r] + 1]++] = r;
+		}
+	}
+
+	/* Pass 4: Breadth-First from the root. Node indices are handed out in visiting
+	   order, so the record at queue position i becomes node i. */
+	int* queue = recordMother; /* Mothers are resolved, reuse the array */
+	queue[0] = 0;
+	int tail = 1;
+	indexAppend(newNode(recordName[0]));
+	for (int head = 0; head < tail; ++head)
+	{
+		int record = queue[head];
+		for (int k = childStart[record]; k < childStart[record + 1]; ++k)
+		{
+			int child = children[k];
+			queue[tail++] = child;
+			/* The first node with a name in visiting order is the one BFSearch finds */
+			indexAppend(linkChild(head, recordName[child]));
+		}
+	}
+
+	printf("Added %d\n", tail);
+	if(tail < numRecords)
+	{
+		printf("Unsuccessful %d\n", numRecords - tail);
+	}
+
+	free(firstRecord);
+	free(recordName);
+	free(recordMother);
+	free(childStart);
+	free(children);
 }
 
 /* --------------- Mother-daughter tree helper functions ---- ----------- */
@@ -247,7 +1017,7 @@ addRoot: Adds person with a given name at the root.
 void addRoot(char* name)
 {
 	printf("Added\n");
-	strncpy(treeRoot.name, name, 20);
+	indexInsert(newNode(internString(name))); /* Root is node 0 */
 }
 
 
@@ -257,8 +1027,8 @@ addNonRoot: Adds person with a given name and mother's name to the tree.
 */
 void addNonRoot(char* name, char* motherName)
 {
-	tnode_t* motherNode = BFSearch(&treeRoot, motherName);
-	if(motherNode == NULL)
+	int motherNode = indexSearch(motherName);
+	if(motherNode == NO_NODE)
 	{
 		printf("Unsuccessful\n");
 		return;
@@ -273,12 +1043,12 @@ queryMother: Prints the Mother's name of the queried daughter node.
 */
 void queryMother(char* name)
 {
-	tnode_t* daughterNode = BFSearch(&treeRoot, name);
-	if(daughterNode != NULL) /* Check if daughter exists */
+	int daughterNode = indexSearch(name);
+	if(daughterNode != NO_NODE) /* Check if daughter exists */
 	{
-		if(daughterNode->parent != NULL) /* Check if the mother exists */
+		if(tree.parent[daughterNode] != NO_NODE) /* Check if the mother exists */
 		{
-			printf("%s\n", (daughterNode->parent)->name);
+			printf("%s\n", stringOf(tree.nameIds[tree.parent[daughterNode]]));
 		}
 	}
 	printf("Not Found\n");
@@ -291,16 +1061,16 @@ queryMother: Prints every daughter's name of the queried mother node.
 */
 void queryDaughters(char* name)
 {
-	tnode_t* motherNode = BFSearch(&treeRoot, name);
-	if(motherNode == NULL)
+	int motherNode = indexSearch(name);
+	if(motherNode == NO_NODE)
 	{
 		printf("Not Found\n");
 		return;
 	}
 
-	for (int i = 0; i < motherNode->numChildren; ++i)
+	for (int child = tree.firstChild[motherNode]; child != NO_NODE; child = tree.nextSibling[child])
 	{
-		printf("%s ", (motherNode->children[i]).name);
+		printf("%s ", stringOf(tree.nameIds[child]));
 	}
 	printf("\n");
 }
@@ -311,37 +1081,98 @@ queryMother: Prints every sister's name of the queried daughter node.
 */
 void querySisters(char* name)
 {
-	tnode_t* daughterNode = BFSearch(&treeRoot, name);
-	if(daughterNode == NULL)
+	int daughterNode = indexSearch(name);
+	if(daughterNode == NO_NODE)
 	{
 		printf("Not Found\n");
 		return;
 	}
 
-	tnode_t* motherNode = daughterNode->parent;
-	for (int i = 0; i < motherNode->numChildren; ++i)
+	int motherNode = tree.parent[daughterNode];
+	if(motherNode == NO_NODE) /* The root has no sisters */
+	{
+		printf("\n");
+		return;
+	}
+
+	for (int sister = tree.firstChild[motherNode]; sister != NO_NODE; sister = tree.nextSibling[sister])
 	{
-		char* sisterName = (motherNode->children[i]).name;
-		if(!strcmp(sisterName, name))
+		if(tree.nameIds[sister] == tree.nameIds[daughterNode])
 		{
 			continue; /* Skip the queried daughter */
 		}
-		printf("%s ", sisterName);
+		printf("%s ", stringOf(tree.nameIds[sister]));
 	}
 	printf("\n");
 }
 
+/*
+queryLineage: Prints the queried woman and every descendant, generation by generation.
+@param name: The name of the woman which will be quried.
+@param numThreads: The number of threads walking each wide generation (1 walks it alone)
+*/
+void queryLineage(char* name, int numThreads)
+{
+	if(numThreads > 1)
+	{
+		/* Finds the same woman as the name index, one generation at a time */
+		int womanNode = BFSearchParallel(0, name, &frontier, numThreads);
+		if(womanNode == NO_NODE)
+		{
+			printf("Not Found\n");
+			return;
+		}
+		BFPrintParallel(womanNode, &frontier, numThreads);
+		return;
+	}
 
-int main()
+	int womanNode = indexSearch(name);
+	if(womanNode == NO_NODE)
+	{
+		printf("Not Found\n");
+		return;
+	}
+	BFPrint(womanNode, &frontier);
+}
+
+
+int main(int argc, char* argv[])
 {
+	int bulk = 0; // --bulk: Whole lineage first, in any order
+	char* loadPath = NULL; // --load <file>: Start from a snapshot instead of a root
+	char* savePath = NULL; // --save <file>: Write a snapshot after the operations
+	int numThreads = 1; // --threads <n>: Threads for the Lineage traversals
+	for (int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--bulk") == 0) bulk = 1;
+		else if(strcmp(argv[i], "--load") == 0 && i + 1 < argc) loadPath = argv[++i];
+		else if(strcmp(argv[i], "--save") == 0 && i + 1 < argc) savePath = argv[++i];
+		else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc) numThreads = atoi(argv[++i]);
+	}
+
 	char input[64]; // Input operation name
 	char name[25]; // The name of the woman
 	char motherName[25]; // The number of woman's mother
-	int numOperations; // The number of operations.
+	int numOperations = 0; // The number of operations (0 if none could be read)
+	int firstOperation = 1; // The root counts as the first operation
 	scanf("%d", &numOperations);
-	scanf("\n%s", name);
-	addRoot(name);
-	for (int i = 1 ; i < numOperations ; i ++)
+	if(loadPath != NULL)
+	{
+		loadSnapshot(loadPath); /* Only operations follow */
+		firstOperation = 0;
+	}
+	else if(bulk)
+	{
+		bulkLoad(numOperations); /* The count was the number of records */
+		scanf("%d", &numOperations);
+		firstOperation = 0;
+	}
+	else
+	{
+		scanf("\n%s", name);
+		addRoot(name);
+	}
+	for (int i = firstOperation ; i < numOperations ; i ++)
 	{
 		scanf("\n%s ", input);
 		if (strcmp(input, "Add") == 0)
@@ -359,11 +1190,24 @@ int main()
 			scanf("%s", name);
 			queryDaughters(name);
 		}
+		else if (strcmp(input, "Lineage") == 0)
+		{
+			scanf("%s", name);
+			queryLineage(name, numThreads);
+		}
 		else
 		{
 			scanf("%s", name);
 			querySisters(name);
 		}
 	}
-	freeTree(&treeRoot); /* Free all nodes from the tree */
+	if(savePath != NULL)
+	{
+		saveSnapshot(savePath);
+	}
+	freeTree(); /* Free all nodes from the tree (Or unmap the snapshot) */
+	free(nameIndex.nodes);
+	freeStrings();
+	freeFrontier(&frontier);
+	return 0;
 }
\ No newline at end of file
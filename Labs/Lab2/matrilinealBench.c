@@ -0,0 +1,188 @@
+/*
+	Matrilineal Traversal Benchmark
+	Compares the reusable array frontier in matrilineal.c against the original
+	calloc-per-node linked list queue on full Breadth-First walks of a large
+	random tree (A search for a name that does not exist).
+
+	Build: gcc -O2 -o matrilinealBench matrilinealBench.c
+	Usage: ./matrilinealBench [numNodes] [numWalks]
+*/
+
+#define main matrilinealMain
+#include "matrilineal.c"
+#undef main
+
+#include <time.h>
+
+/* --------------- Original linked list-based Queue --------------- */
+
+/* Singly linked list node */
+typedef struct _llnode
+{
+	int node;
+	struct _llnode* nextNode;
+} llnode_t;
+
+/* Linked List */
+typedef struct _linkedlist
+{
+	llnode_t* head;
+	llnode_t* tail;
+} linkedlist_t;
+
+long listAllocations = 0; /* Nodes allocated by the linked list queue */
+
+/*
+listEnqueue: Add a tree node to a specified queue (One calloc per node).
+@param _node: Index of the tree node
+@param _queue: Pointer to the queue
+*/
+void listEnqueue(int _node, linkedlist_t* _queue)
+{
+	llnode_t* newNode = calloc(1, sizeof(llnode_t));
+	if(newNode == NULL)
+	{
+		printf("Failed to allocate new node\n");
+		exit(1);
+	}
+	++listAllocations;
+	newNode->node = _node;
+	newNode->nextNode = NULL;
+	if(_queue->tail != NULL)
+	{
+		(_queue->tail)->nextNode = newNode;
+	}
+	if(_queue->head == NULL)
+	{
+		_queue->head = newNode;
+	}
+	_queue->tail = newNode;
+}
+
+/*
+listDequeue: Remove a tree node from a specified queue (One free per node).
+@param _queue: Pointer to the queue
+@return: Index of the tree node
+*/
+int listDequeue(linkedlist_t* _queue)
+{
+	llnode_t* prevHead = _queue->head;
+	int item = prevHead->node;
+	_queue->head = prevHead->nextNode;
+	if(_queue->head == NULL)
+	{
+		_queue->tail = NULL;
+	}
+	free(prevHead);
+	return item;
+}
+
+/*
+listBFSearch: BFSearch as it was before the frontier, one queue node per visited node.
+@param _root: Index of the root node of the tree/subtree
+@param _name: The name to search for in the tree/subtree
+@param visited: Set to the number of visited nodes
+@return: Index of the first matching node, NO_NODE if not found
+*/
+int listBFSearch(int _root, char* _name, long* visited)
+{
+	linkedlist_t _queue = { NULL, NULL };
+	listEnqueue(_root, &_queue);
+	*visited = 0;
+	while(_queue.head != NULL)
+	{
+		int frontNode = listDequeue(&_queue);
+		++*visited;
+		if(!strcmp(stringOf(tree.nameIds[frontNode]), _name))
+		{
+			while(_queue.head != NULL)
+			{
+				listDequeue(&_queue);
+			}
+			return frontNode;
+		}
+		for (int child = tree.firstChild[frontNode]; child != NO_NODE; child = tree.nextSibling[child])
+		{
+			listEnqueue(child, &_queue);
+		}
+	}
+	return NO_NODE;
+}
+
+/* --------------- Benchmark --------------- */
+
+/*
+elapsedSeconds: Returns the seconds elapsed between two timestamps.
+@param start: The earlier timestamp
+@param end: The later timestamp
+@return: Elapsed time in seconds
+*/
+double elapsedSeconds(struct timespec start, struct timespec end)
+{
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/*
+buildTree: Grows a random tree, each person's mother is picked among the
+	most recent people so generations stay a few hundred wide.
+@param numNodes: The number of people in the tree
+*/
+void buildTree(int numNodes)
+{
+	char name[NAME_LENGTH];
+	unsigned int seed = 12345;
+	indexInsert(newNode(internString("P0")));
+	for (int i = 1; i < numNodes; ++i)
+	{
+		seed = seed * 1103515245u + 12345u;
+		int window = (i < 1024) ? i : 1024;
+		int mother = i - 1 - (int)((seed >> 8) % window);
+		sprintf(name, "P%d", i);
+		insertChild(mother, name);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int numNodes = (argc > 1) ? atoi(argv[1]) : 4000000;
+	int numWalks = (argc > 2) ? atoi(argv[2]) : 5;
+	buildTree(numNodes);
+
+	struct timespec start, end;
+	long listVisited = 0;
+	long frontierVisited = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < numWalks; ++i)
+	{
+		long visited;
+		listBFSearch(0, "Nobody", &visited);
+		listVisited += visited;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double listTime = elapsedSeconds(start, end);
+
+	/* First walk sizes the frontier, the remaining walks reuse it. BFSearch would not
+	   walk at all for a name nobody has, so walk the whole tree directly. */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < numWalks; ++i)
+	{
+		BFTraverse(0, NO_NODE, &frontier);
+		frontierVisited += frontier.count;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double frontierTime = elapsedSeconds(start, end);
+
+	printf("Nodes: %d, walks: %d\n", numNodes, numWalks);
+	printf("linkedlist_t: %.3f s (%.1f M nodes/s, %ld allocations)\n",
+		listTime, listVisited / listTime / 1e6, listAllocations);
+	printf("frontier_t:   %.3f s (%.1f M nodes/s, buffer of %d nodes)\n",
+		frontierTime, frontierVisited / frontierTime / 1e6, frontier.capacity);
+	printf("Visits %s\n", (listVisited == frontierVisited) ? "match" : "DIFFER");
+
+	freeTree();
+	free(nameIndex.nodes);
+	freeStrings();
+	freeFrontier(&frontier);
+	return (listVisited == frontierVisited) ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+/*
+	Matrilineal Parallel Traversal Scaling Benchmark
+	Walks a large, wide random tree with the level-synchronous traversal in
+	matrilineal.c on 1, 2, 4, ... up to the requested number of threads, and
+	checks every result against the single-threaded BFTraverse.
+
+	Build: gcc -O2 -pthread -o matrilinealScaling matrilinealScaling.c
+	Usage: ./matrilinealScaling [maxThreads] [numNodes]
+*/
+
+#define main matrilinealMain
+#include "matrilineal.c"
+#undef main
+
+#include <time.h>
+
+#define NUM_SEARCHES 16 /* Names searched for on every thread count */
+
+/*
+elapsedSeconds: Returns the seconds elapsed between two timestamps.
+@param start: The earlier timestamp
+@param end: The later timestamp
+@return: Elapsed time in seconds
+*/
+double elapsedSeconds(struct timespec start, struct timespec end)
+{
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/*
+buildTree: Grows a random tree, each person's mother is picked among the
+	most recent 64K people so generations are tens of thousands wide.
+	Names repeat, so searches have to pick the leftmost of several matches.
+@param numNodes: The number of people in the tree
+*/
+void buildTree(int numNodes)
+{
+	char name[NAME_LENGTH];
+	unsigned int seed = 12345;
+	indexInsert(newNode(internString("P0")));
+	for (int i = 1; i < numNodes; ++i)
+	{
+		seed = seed * 1103515245u + 12345u;
+		int window = (i < 65536) ? i : 65536;
+		int mother = i - 1 - (int)((seed >> 4) % window);
+		sprintf(name, "P%d", i % (numNodes / 4 + 1));
+		insertChild(mother, name);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int maxThreads = (argc > 1) ? atoi(argv[1]) : 16;
+	int numNodes = (argc > 2) ? atoi(argv[2]) : 8000000;
+	buildTree(numNodes);
+
+	/* Reference walk and searches, spread from shallow to deep names */
+	frontier_t expected = { NULL, 0, 0 };
+	BFTraverse(0, NO_NODE, &expected);
+	char searches[NUM_SEARCHES][NAME_LENGTH];
+	int expectedMatches[NUM_SEARCHES];
+	for (int s = 0; s < NUM_SEARCHES; ++s)
+	{
+		sprintf(searches[s], "P%d", (s == NUM_SEARCHES - 1) ? -1 : (int)((long)numNodes / 4 * s / NUM_SEARCHES));
+		expectedMatches[s] = BFSearch(0, searches[s], &frontier);
+	}
+
+	printf("Nodes: %d\n", numNodes);
+	for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+	{
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		BFTraverseParallel(0, NO_NODE, &frontier, numThreads);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		double walkTime = elapsedSeconds(start, end);
+		int consistent = (frontier.count == expected.count) &&
+			!memcmp(frontier.nodes, expected.nodes, expected.count * sizeof(int));
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int s = 0; s < NUM_SEARCHES; ++s)
+		{
+			consistent &= (BFSearchParallel(0, searches[s], &frontier, numThreads) == expectedMatches[s]);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		double searchTime = elapsedSeconds(start, end);
+
+		printf("%2d threads: walk %.3f s (%.1f M nodes/s), %d searches %.3f s%s\n",
+			numThreads, walkTime, expected.count / walkTime / 1e6, NUM_SEARCHES, searchTime,
+			consistent ? "" : " INCONSISTENT");
+	}
+
+	freeTree();
+	free(nameIndex.nodes);
+	freeStrings();
+	freeFrontier(&frontier);
+	freeFrontier(&expected);
+	return 0;
+}
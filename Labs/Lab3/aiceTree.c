@@ -10,6 +10,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define KEY_BASE_YEAR 1970 /* Packed keys hold the years KEY_BASE_YEAR to KEY_BASE_YEAR + 126 */
+#define KEY_UNPACKED (~0ULL) /* Key of a competency that does not fit, compared field by field */
+#define MAX_SORT_THREADS 8
+#define SORT_MIN_CHUNK 65536 /* Smallest share of the records worth a sorting thread */
 
 /* --------------- Data structures --------------- */
 
@@ -20,6 +27,9 @@ typedef struct _tnode
 	struct _tnode* parent; /* The parent of the node */
 	struct _tnode* leftChild; /* Pointer to an array of children */
 	struct _tnode* rightChild; /* Pointer to an array of children */
+	int height; /* Levels in the subtree, 1 for a leaf (Kept within one between sides) */
+	int count; /* Competencies in the subtree, the node included */
+	unsigned long credits; /* Credits of every competency in the subtree */
 } tnode_t;
 
 /* Competency info structure */
@@ -30,23 +40,59 @@ typedef struct _info
     unsigned int credit;
     unsigned int year;
     int semester; /* Spring = 0, Fall = 1 */
+    unsigned long long key; /* Year, semester and code packed in the same order, see packKey */
 } info_t;
 
+/* Sort entry of the catalogue builder, the key is copied so sorting rarely touches the records */
+typedef struct _sortentry
+{
+    unsigned long long key;
+    int record; /* Index in reading order, equal competencies keep the first read */
+} sortentry_t;
+
+/* One thread of the parallel sort, sorts from[start, end) in place or merges
+   from[start, middle) and from[middle, end) into to[start, end) */
+typedef struct _sortworker
+{
+    pthread_t thread;
+    sortentry_t* from;
+    sortentry_t* to;
+    int start;
+    int middle; /* -1 to sort instead of merging */
+    int end;
+} sortworker_t;
+
+/* Read-optimized catalogue: every competency in order in one contiguous array, and an
+   Eytzinger (Breadth-First) copy of their keys, so that the first levels of every
+   search share the same few cache lines */
+typedef struct _catalogue
+{
+    info_t* records; /* Sorted, without duplicates */
+    int count;
+    unsigned long long* eytzinger; /* eytzinger[1..count], the children of slot k are 2k and 2k + 1 */
+    int* eytzingerRank; /* Position in records of the key in each slot */
+    int allPacked; /* 0 if any key is KEY_UNPACKED, searches then compare field by field */
+    unsigned long* creditsBefore; /* creditsBefore[i] adds up the credits of records[0..i) */
+} catalogue_t;
+
 /* --------------- Global variables --------------- */
 
-tnode_t treeRoot = { NULL, NULL, NULL, NULL };
+tnode_t* treeRoot = NULL; /* Changes when a rotation lifts another node to the top */
+catalogue_t catalogue = { NULL, 0, NULL, NULL, 1, NULL }; /* Only built in bulk mode */
+info_t* readRecords = NULL; /* Records in reading order while the catalogue is sorted */
 
-/* --------------- Binary Search Tree implementation --------------- */
+/* --------------- AVL Binary Search Tree implementation --------------- */
 
 /* 
 insertChild: Add a new child node to the parent node in the binary tree.
 @param _data: Pointer to the node data
-@param _parent: Pointer to the parent node
+@param _parent: Pointer to the parent node, NULL to add the root
 @param childSide: The side in which the child will be added (-1 for left, 1 for right)
+@return: Pointer to the new node, NULL if it could not be added
 */
-void insertNode(void* _data, tnode_t* _parent, int childSide)
+tnode_t* insertNode(void* _data, tnode_t* _parent, int childSide)
 {
-    if((childSide != -1) && (childSide != 1)) return; /* left or right only */
+    if(_parent != NULL && (childSide != -1) && (childSide != 1)) return NULL; /* left or right only */
 
     tnode_t* newNode = calloc(1, sizeof(tnode_t));
     if(newNode == NULL)
@@ -56,12 +102,14 @@ void insertNode(void* _data, tnode_t* _parent, int childSide)
     }
 
     /* A pointer to the pointer which points to the child node of the correct side */
-    tnode_t** childPtr = (childSide == -1) ? &_parent->leftChild : &_parent->rightChild;
+    tnode_t** childPtr = (_parent == NULL) ? &treeRoot :
+        (childSide == -1) ? &_parent->leftChild : &_parent->rightChild;
     if(*childPtr != NULL)
     {
         /* Another child already exists in that position */
         printf("There is already a child node in that position\n");
-        return;
+        free(newNode);
+        return NULL;
     }
 
     /* Fill in node attributes */
@@ -69,21 +117,183 @@ void insertNode(void* _data, tnode_t* _parent, int childSide)
     newNode->parent = _parent;
     newNode->leftChild = NULL;
     newNode->rightChild = NULL;
+    newNode->height = 1;
+    newNode->count = 1;
+    newNode->credits = ((info_t*)_data)->credit;
 
     /* Assign the parent's pointer to the child (of the correct side) */
     *childPtr = newNode; 
+    return newNode;
+}
+
+/* 
+nodeHeight: Returns the height of a tree/subtree.
+@param node: Pointer to the root of the tree/subtree
+@return: The number of levels, 0 for an empty subtree
+*/
+int nodeHeight(tnode_t* node)
+{
+    return (node == NULL) ? 0 : node->height;
+}
+
+/* 
+nodeCount: Returns the number of competencies in a tree/subtree.
+@param node: Pointer to the root of the tree/subtree
+@return: The number of competencies, 0 for an empty subtree
+*/
+int nodeCount(tnode_t* node)
+{
+    return (node == NULL) ? 0 : node->count;
+}
+
+/* 
+nodeCredits: Returns the credits of every competency in a tree/subtree.
+@param node: Pointer to the root of the tree/subtree
+@return: The total credits, 0 for an empty subtree
+*/
+unsigned long nodeCredits(tnode_t* node)
+{
+    return (node == NULL) ? 0 : node->credits;
+}
+
+/* 
+updateNode: Recomputes the height, count and credits of a node from its children.
+@param node: Pointer to the node
+*/
+void updateNode(tnode_t* node)
+{
+    int leftHeight = nodeHeight(node->leftChild);
+    int rightHeight = nodeHeight(node->rightChild);
+    node->height = 1 + ((leftHeight > rightHeight) ? leftHeight : rightHeight);
+    node->count = nodeCount(node->leftChild) + 1 + nodeCount(node->rightChild);
+    node->credits = nodeCredits(node->leftChild) + ((info_t*)node->data)->credit + nodeCredits(node->rightChild);
+}
+
+/* 
+rotate: Moves a node one level down to a side, its child from the other side takes its place.
+@param node: Pointer to the node
+@param childSide: The side the node moves to (-1 for left, 1 for right)
+@return: Pointer to the node that took its place
+*/
+tnode_t* rotate(tnode_t* node, int childSide)
+{
+    tnode_t* child;
+    if(childSide == -1) /* The right child rises */
+    {
+        child = node->rightChild;
+        node->rightChild = child->leftChild;
+        if(node->rightChild != NULL) node->rightChild->parent = node;
+        child->leftChild = node;
+    }
+    else /* The left child rises */
+    {
+        child = node->leftChild;
+        node->leftChild = child->rightChild;
+        if(node->leftChild != NULL) node->leftChild->parent = node;
+        child->rightChild = node;
+    }
+
+    /* The child hangs where the node used to */
+    child->parent = node->parent;
+    if(node->parent == NULL) treeRoot = child;
+    else if(node->parent->leftChild == node) node->parent->leftChild = child;
+    else node->parent->rightChild = child;
+    node->parent = child;
+
+    updateNode(node);
+    updateNode(child);
+    return child;
+}
+
+/* 
+rebalance: Restores the AVL balance on the way up from a new node's parent. Once a
+    subtree keeps its height no more rotations are needed above it, but every ancestor
+    still gains the new competency in its count and credits.
+@param node: Pointer to the parent of the new node
+*/
+void rebalance(tnode_t* node)
+{
+    while(node != NULL)
+    {
+        int oldHeight = node->height;
+        int balance = nodeHeight(node->leftChild) - nodeHeight(node->rightChild);
+        if(balance > 1) /* Left side too tall */
+        {
+            tnode_t* left = node->leftChild;
+            if(nodeHeight(left->leftChild) < nodeHeight(left->rightChild))
+            {
+                rotate(left, -1);
+            }
+            node = rotate(node, 1);
+        }
+        else if(balance < -1) /* Right side too tall */
+        {
+            tnode_t* right = node->rightChild;
+            if(nodeHeight(right->rightChild) < nodeHeight(right->leftChild))
+            {
+                rotate(right, 1);
+            }
+            node = rotate(node, -1);
+        }
+        else
+        {
+            updateNode(node);
+        }
+
+        if(node->height == oldHeight) break;
+        node = node->parent;
+    }
+
+    for (node = (node == NULL) ? NULL : node->parent; node != NULL; node = node->parent)
+    {
+        updateNode(node);
+    }
 }
 
 /* --------------- Helper functions ---- ----------- */
 
+/* 
+packKey: Packs a competency's order into one integer. The top byte holds the year
+    (From KEY_BASE_YEAR) and the semester, the other seven hold the code big-endian
+    and zero-padded, so comparing keys matches comparing year, semester, then strcmp.
+@param competency: Pointer to the competency info
+@return: The packed key, KEY_UNPACKED if the year or semester is out of range
+*/
+unsigned long long packKey(info_t* competency)
+{
+    if(competency->year < KEY_BASE_YEAR || competency->year - KEY_BASE_YEAR > 126 ||
+        (competency->semester != 0 && competency->semester != 1))
+    {
+        return KEY_UNPACKED;
+    }
+
+    unsigned long long key = ((competency->year - KEY_BASE_YEAR) << 1) | competency->semester;
+    for (int i = 0; i < 7; ++i) /* Codes are at most 7 characters */
+    {
+        key = (key << 8) | (unsigned char)competency->code[i];
+        if(competency->code[i] == '\0')
+        {
+            key <<= 8 * (6 - i); /* Pad with zeros, shorter codes come first */
+            break;
+        }
+    }
+    return key;
+}
+
 /* 
 compareCompetency: Compares two competencies and determine which has a higher order. 
 @param info1: Pointer to the competency info (1st)
 @param info2: Pointer to the competency info (2nd)
-@return: Returns -1/0/1 if the 1st info has a lower/equal/higher order respectively
+@return: Returns a negative/zero/positive value if the 1st info has a lower/equal/higher order respectively
 */
 int compareCompetency(info_t* info1, info_t* info2)
 {
+    /* Single integer compare when both keys are packed */
+    if(info1->key != KEY_UNPACKED && info2->key != KEY_UNPACKED)
+    {
+        return (info1->key > info2->key) - (info1->key < info2->key);
+    }
+
     /* Compares by year */
     if(info1->year < info2->year) return -1;
     if(info1->year > info2->year) return 1;
@@ -96,24 +306,33 @@ int compareCompetency(info_t* info1, info_t* info2)
     return strcmp(info1->code, info2->code);
 }
 
+/* 
+compareSemester: Compares the semester a competency was offered in with another semester.
+@param competency: Pointer to the competency info
+@param year: The year of the other semester
+@param semester: The other semester within that year
+@return: Returns a negative/zero/positive value if the competency was offered before/in/after that semester
+*/
+int compareSemester(info_t* competency, int year, int semester)
+{
+    unsigned int queryYear = year; /* Converted the way fillInfo stores a year, so the tree's order holds */
+    if(competency->year != queryYear) return (competency->year > queryYear) - (competency->year < queryYear);
+    return (competency->semester > semester) - (competency->semester < semester);
+}
+
 
 /* 
-createNode: Creates the info struct containing compentency's information.
+fillInfo: Fills an info struct with a compentency's information.
+@param newInfo: Pointer to the competency info
 @param competency_code: Pointer to the competency code
 @param competency_title: Pointer to the competency title
 @param credit: The amount of credits the competency offers
 @param year: The year when the competency was offered
 @param semester: The semester when the competency was offered within that year
-@return: Returns a pointer to the allocated competency info struct.
 */
-info_t* createNode(char* competency_code, char* competency_title, int credit, int year, int semester)
+void fillInfo(info_t* newInfo, char* competency_code, char* competency_title, int credit, int year, int semester)
 {
-    info_t* newInfo = calloc(1, sizeof(info_t));
-    if(newInfo == NULL)
-    {
-        printf("Failed to allocate new competency info\n");
-        exit(1);
-    }
+    memset(newInfo, 0, sizeof(info_t));
 
     /* Fill in info attributes */
     strncpy(newInfo->code, competency_code, strlen(competency_code));
@@ -123,44 +342,133 @@ info_t* createNode(char* competency_code, char* competency_title, int credit, in
     newInfo->credit = credit;
     newInfo->year = year;
     newInfo->semester = semester;
+    newInfo->key = packKey(newInfo);
+}
 
+/* 
+createNode: Creates the info struct containing compentency's information.
+@param competency_code: Pointer to the competency code
+@param competency_title: Pointer to the competency title
+@param credit: The amount of credits the competency offers
+@param year: The year when the competency was offered
+@param semester: The semester when the competency was offered within that year
+@return: Returns a pointer to the allocated competency info struct.
+*/
+info_t* createNode(char* competency_code, char* competency_title, int credit, int year, int semester)
+{
+    info_t* newInfo = calloc(1, sizeof(info_t));
+    if(newInfo == NULL)
+    {
+        printf("Failed to allocate new competency info\n");
+        exit(1);
+    }
+    fillInfo(newInfo, competency_code, competency_title, credit, year, semester);
     return newInfo;
 }
 
 
 /* 
-insert: Insert a new node into the binary tree.
+insert: Insert a new node into the binary tree, rebalancing it on the way back up.
+    A competency already in the tree is dropped, the first one read is kept.
 @param competency: Pointer to the competency info
 */
 void insert(info_t* competency)
 {
-    if(treeRoot.data == NULL)
+    tnode_t* parent = NULL;
+    int direction = 0;
+    tnode_t* currentNode = treeRoot;
+    while(currentNode != NULL)
     {
-        treeRoot.data = competency;
+        /* Tells the direction the new node should go */
+        int order = compareCompetency(competency, currentNode->data);
+        if(order == 0) /* Exits if competency is found */
+        {
+            free(competency);
+            return;
+        }
+        direction = (order < 0) ? -1 : 1;
+        parent = currentNode;
+        currentNode = (direction < 0) ? currentNode->leftChild : currentNode->rightChild;
     }
 
-    tnode_t* currentNode = &treeRoot;
-    while(compareCompetency(currentNode->data, competency)) /* Exits if competency is found */
+    insertNode(competency, parent, direction);
+    rebalance(parent);
+}
+
+/* 
+findCompetency: Looks a competency up in the binary tree.
+@param competency: Pointer to a competency info with the same year, semester and code
+@return: Pointer to the matching node, NULL if not found
+*/
+tnode_t* findCompetency(info_t* competency)
+{
+    tnode_t* node = treeRoot;
+    while(node != NULL)
     {
-        /* Tells the direction the new node should go */
-        int direction = compareCompetency(competency, currentNode->data); 
-        if(direction < 0) /* Go left */
+        int order = compareCompetency(competency, node->data);
+        if(order == 0) return node;
+        node = (order < 0) ? node->leftChild : node->rightChild;
+    }
+    return NULL;
+}
+
+/* 
+countBefore: Counts the competencies offered before a semester and adds up their credits,
+    taking whole left subtrees at once on a single walk down the tree.
+@param year: The year of the semester
+@param semester: The semester within that year
+@param inclusive: 1 to count the competencies offered in the semester as well
+@param credits: Set to the credits of the competencies counted
+@return: The number of competencies offered before (Or up to) the semester
+*/
+int countBefore(int year, int semester, int inclusive, unsigned long* credits)
+{
+    int count = 0;
+    *credits = 0;
+    tnode_t* node = treeRoot;
+    while(node != NULL)
+    {
+        if(compareSemester(node->data, year, semester) < inclusive)
         {
-            if(currentNode->leftChild == NULL) 
-            {
-                insertNode(competency, currentNode, direction);
-            }
-            currentNode = currentNode->leftChild;
+            /* The node and everything on its left come before */
+            count += nodeCount(node->leftChild) + 1;
+            *credits += nodeCredits(node->leftChild) + ((info_t*)node->data)->credit;
+            node = node->rightChild;
         }
-        else /* Go right */
+        else
         {
-            if(currentNode->rightChild == NULL) 
-            {
-                insertNode(competency, currentNode, direction);
-            }
-            currentNode = currentNode->rightChild;
+            node = node->leftChild;
         }
     }
+    return count;
+}
+
+/* 
+kthCompetency: Finds the competency at a position of the in-order traversal.
+@param k: The position, 1 for the first competency
+@return: Pointer to the node at that position, NULL if there is none
+*/
+tnode_t* kthCompetency(int k)
+{
+    tnode_t* node = treeRoot;
+    while(node != NULL)
+    {
+        int leftCount = nodeCount(node->leftChild);
+        if(k <= leftCount)
+        {
+            node = node->leftChild;
+        }
+        else if(k == leftCount + 1)
+        {
+            return node;
+        }
+        else
+        {
+            k -= leftCount + 1;
+            node = node->rightChild;
+        }
+    }
+    return NULL;
 }
 
 /* 
@@ -206,21 +514,413 @@ void freeAll(tnode_t* node)
 	node = NULL;
 }
 
-int main()
+/* --------------- Read-optimized catalogue --------------- */
+
+/* 
+compareEntries: qsort comparator of sort entries, by competency order then reading order.
+@param _first: Pointer to the first sort entry
+@param _second: Pointer to the second sort entry
+@return: Negative/zero/positive if the first entry comes before/with/after the second
+*/
+int compareEntries(const void* _first, const void* _second)
+{
+    const sortentry_t* first = _first;
+    const sortentry_t* second = _second;
+    int order;
+    if(first->key != KEY_UNPACKED && second->key != KEY_UNPACKED)
+    {
+        order = (first->key > second->key) - (first->key < second->key);
+    }
+    else
+    {
+        order = compareCompetency(&readRecords[first->record], &readRecords[second->record]);
+    }
+    if(order != 0) return order;
+    return first->record - second->record;
+}
+
+/* 
+runSortWorker: Thread body of the parallel sort, sorts or merges the worker's range.
+@param _arg: Pointer to the worker
+*/
+void* runSortWorker(void* _arg)
+{
+    sortworker_t* worker = _arg;
+    if(worker->middle < 0)
+    {
+        qsort(worker->from + worker->start, worker->end - worker->start, sizeof(sortentry_t), compareEntries);
+        return NULL;
+    }
+
+    /* Already in order (Sorted input), the merge is a plain copy */
+    if(compareEntries(&worker->from[worker->middle - 1], &worker->from[worker->middle]) <= 0)
+    {
+        memcpy(worker->to + worker->start, worker->from + worker->start, (worker->end - worker->start) * sizeof(sortentry_t));
+        return NULL;
+    }
+
+    int left = worker->start;
+    int right = worker->middle;
+    for (int i = worker->start; i < worker->end; ++i)
+    {
+        if(right == worker->end || (left < worker->middle && compareEntries(&worker->from[left], &worker->from[right]) <= 0))
+        {
+            worker->to[i] = worker->from[left++];
+        }
+        else
+        {
+            worker->to[i] = worker->from[right++];
+        }
+    }
+    return NULL;
+}
+
+/* 
+runSortWorkers: Runs workers on their own threads, the calling thread takes the first one.
+@param workers: The workers
+@param numWorkers: The number of workers
+*/
+void runSortWorkers(sortworker_t* workers, int numWorkers)
+{
+    for (int t = 1; t < numWorkers; ++t)
+    {
+        if(pthread_create(&workers[t].thread, NULL, runSortWorker, &workers[t]) != 0)
+        {
+            printf("Failed to create sorting thread\n");
+            exit(1);
+        }
+    }
+    runSortWorker(&workers[0]);
+    for (int t = 1; t < numWorkers; ++t)
+    {
+        pthread_join(workers[t].thread, NULL);
+    }
+}
+
+/* 
+sortEntries: Sorts entries with one thread per core (At most MAX_SORT_THREADS): every thread
+    sorts a chunk, then sorted chunks are merged in pairs, each pair on its own thread.
+@param entries: The entries
+@param count: The number of entries
+@return: Pointer to the sorted entries (Either the original array or a new one, the other is freed)
+*/
+sortentry_t* sortEntries(sortentry_t* entries, int count)
+{
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int numThreads = 1;
+    while(numThreads * 2 <= MAX_SORT_THREADS && numThreads * 2 <= cores && count / (numThreads * 2) >= SORT_MIN_CHUNK)
+    {
+        numThreads *= 2;
+    }
+
+    int bounds[MAX_SORT_THREADS + 1];
+    sortworker_t workers[MAX_SORT_THREADS];
+    for (int t = 0; t <= numThreads; ++t)
+    {
+        bounds[t] = (int)((long)count * t / numThreads);
+    }
+    for (int t = 0; t < numThreads; ++t)
+    {
+        workers[t] = (sortworker_t){ 0, entries, NULL, bounds[t], -1, bounds[t + 1] };
+    }
+    runSortWorkers(workers, numThreads);
+    if(numThreads == 1)
+    {
+        return entries;
+    }
+
+    sortentry_t* scratch = malloc(count * sizeof(sortentry_t));
+    if(scratch == NULL)
+    {
+        printf("Failed to allocate catalogue\n");
+        exit(1);
+    }
+    for (int width = 1; width < numThreads; width *= 2)
+    {
+        int numWorkers = 0;
+        for (int t = 0; t < numThreads; t += 2 * width)
+        {
+            workers[numWorkers++] = (sortworker_t){ 0, entries, scratch, bounds[t], bounds[t + width], bounds[t + 2 * width] };
+        }
+        runSortWorkers(workers, numWorkers);
+        sortentry_t* merged = scratch;
+        scratch = entries;
+        entries = merged;
+    }
+    free(scratch);
+    return entries;
+}
+
+/* 
+fillEytzinger: Lays the sorted keys out in Eytzinger order (An in-order walk of the implicit tree).
+@param position: The next sorted position to place
+@param slot: The Eytzinger slot to fill
+@return: The next sorted position to place after the slot's subtree
+*/
+int fillEytzinger(int position, int slot)
+{
+    if(slot > catalogue.count) return position;
+
+    position = fillEytzinger(position, 2 * slot);
+    catalogue.eytzinger[slot] = catalogue.records[position].key;
+    catalogue.eytzingerRank[slot] = position;
+    return fillEytzinger(position + 1, 2 * slot + 1);
+}
+
+/* 
+sortCatalogue: Sorts the records read into readRecords in parallel, keeps the first of any
+    duplicates in the catalogue and builds the Eytzinger search index. Frees readRecords.
+@param numRecords: The number of records read
+*/
+void sortCatalogue(int numRecords)
+{
+    sortentry_t* entries = malloc(numRecords * sizeof(sortentry_t));
+    catalogue.records = malloc(numRecords * sizeof(info_t));
+    catalogue.eytzinger = malloc((numRecords + 1) * sizeof(unsigned long long));
+    catalogue.eytzingerRank = malloc((numRecords + 1) * sizeof(int));
+    catalogue.creditsBefore = malloc((numRecords + 1) * sizeof(unsigned long));
+    if((numRecords > 0 && (entries == NULL || catalogue.records == NULL)) ||
+        catalogue.eytzinger == NULL || catalogue.eytzingerRank == NULL || catalogue.creditsBefore == NULL)
+    {
+        printf("Failed to allocate catalogue\n");
+        exit(1);
+    }
+    for (int i = 0; i < numRecords; i++)
+    {
+        entries[i].key = readRecords[i].key;
+        entries[i].record = i;
+    }
+    entries = sortEntries(entries, numRecords);
+
+    /* Copy the records out in order, the first of equal competencies was read first */
+    catalogue.count = 0;
+    catalogue.allPacked = 1;
+    catalogue.creditsBefore[0] = 0;
+    for (int i = 0; i < numRecords; i++)
+    {
+        info_t* competency = &readRecords[entries[i].record];
+        if(catalogue.count > 0 && compareCompetency(competency, &catalogue.records[catalogue.count - 1]) == 0)
+        {
+            continue;
+        }
+        catalogue.records[catalogue.count++] = *competency;
+        catalogue.allPacked &= (competency->key != KEY_UNPACKED);
+        catalogue.creditsBefore[catalogue.count] = catalogue.creditsBefore[catalogue.count - 1] + competency->credit;
+    }
+    fillEytzinger(0, 1);
+
+    free(entries);
+    free(readRecords);
+    readRecords = NULL;
+}
+
+/* 
+buildCatalogue: Reads every competency into one array (One allocation for all of them),
+    then sorts them into the catalogue.
+@param numRecords: The number of competencies to read
+*/
+void buildCatalogue(int numRecords)
 {
+    char competency_code[8];
+    char competency_title[64];
+    int credit;
+    int year;
+    int semester;
+    readRecords = malloc(numRecords * sizeof(info_t));
+    if(numRecords > 0 && readRecords == NULL)
+    {
+        printf("Failed to allocate catalogue\n");
+        exit(1);
+    }
+    for (int i = 0; i < numRecords; i++)
+    {
+        scanf("%7s %63s %d %d %d", competency_code, competency_title, &credit, &year, &semester);
+        fillInfo(&readRecords[i], competency_code, competency_title, credit, year, semester);
+    }
+    sortCatalogue(numRecords);
+}
+
+/* 
+catalogueFind: Looks a competency up in the catalogue. Walks the Eytzinger index
+    branch-free when every key is packed, otherwise binary searches the records.
+@param competency: Pointer to a competency info with the same year, semester and code
+@return: Pointer to the matching competency in the catalogue, NULL if not found
+*/
+info_t* catalogueFind(info_t* competency)
+{
+    if(catalogue.allPacked && competency->key != KEY_UNPACKED)
+    {
+        unsigned long long key = competency->key;
+        int slot = 1;
+        while(slot <= catalogue.count)
+        {
+            slot = 2 * slot + (catalogue.eytzinger[slot] < key);
+        }
+        /* Undo the right turns taken after the last left turn, that left turn is the first key not below */
+        while(slot & 1)
+        {
+            slot >>= 1;
+        }
+        slot >>= 1;
+        if(slot == 0 || catalogue.eytzinger[slot] != key) return NULL;
+        return &catalogue.records[catalogue.eytzingerRank[slot]];
+    }
+
+    int low = 0;
+    int high = catalogue.count;
+    while(low < high)
+    {
+        int mid = low + (high - low) / 2;
+        int order = compareCompetency(&catalogue.records[mid], competency);
+        if(order == 0) return &catalogue.records[mid];
+        if(order < 0) low = mid + 1;
+        else high = mid;
+    }
+    return NULL;
+}
+
+/* 
+catalogueCountBefore: Counts the competencies in the catalogue offered before a semester
+    and adds up their credits, with a binary search and the running credit totals.
+@param year: The year of the semester
+@param semester: The semester within that year
+@param inclusive: 1 to count the competencies offered in the semester as well
+@param credits: Set to the credits of the competencies counted
+@return: The number of competencies offered before (Or up to) the semester
+*/
+int catalogueCountBefore(int year, int semester, int inclusive, unsigned long* credits)
+{
+    int low = 0;
+    int high = catalogue.count;
+    while(low < high)
+    {
+        int mid = low + (high - low) / 2;
+        if(compareSemester(&catalogue.records[mid], year, semester) < inclusive) low = mid + 1;
+        else high = mid;
+    }
+    *credits = catalogue.creditsBefore[low];
+    return low;
+}
+
+/* 
+printCatalogue: Prints the competencies in the catalogue, in the same order and format as printCompetencies.
+*/
+void printCatalogue()
+{
+    for (int i = 0; i < catalogue.count; i++)
+    {
+        info_t* competency = &catalogue.records[i];
+        printf("%d %d %s %s\n", 
+            competency->year,
+            competency->semester,
+            competency->code,
+            competency->title
+        );
+    }
+}
+
+/* 
+freeCatalogue: Free the catalogue's arrays.
+*/
+void freeCatalogue()
+{
+    free(catalogue.records);
+    free(catalogue.eytzinger);
+    free(catalogue.eytzingerRank);
+    free(catalogue.creditsBefore);
+    catalogue = (catalogue_t){ NULL, 0, NULL, NULL, 1, NULL };
+}
+
+int main(int argc, char* argv[])
+{
+    int bulk = 0; /* --bulk: Read-only sorted catalogue instead of the tree */
+    for (int i = 1; i < argc; ++i)
+    {
+        if(strcmp(argv[i], "--bulk") == 0) bulk = 1;
+    }
+
+
     char competency_code[8];
     char competency_title[64];
     int credit;
     int year;
     int semester; /* Spring = 0, Fall = 1 */ 
     int num_operations; /* The number of operations. */
+    int num_queries; /* The number of queries after the competencies, if any */
 	scanf("%d", &num_operations);
-    for (int i = 0; i < num_operations; i++)
+    if(bulk)
     {
-        scanf("%7s %63s %d %d %d", competency_code, competency_title, &credit, &year, &semester);
-        info_t* newNode = createNode(competency_code, competency_title, credit, year, semester); 
-        insert(newNode); 
+        buildCatalogue(num_operations);
+        printCatalogue();
+    }
+    else
+    {
+        for (int i = 0; i < num_operations; i++)
+        {
+            scanf("%7s %63s %d %d %d", competency_code, competency_title, &credit, &year, &semester);
+            info_t* newNode = createNode(competency_code, competency_title, credit, year, semester); 
+            insert(newNode); 
+        }
+        printCompetencies(treeRoot);
     }
-    printCompetencies(&treeRoot);
-    freeAll(&treeRoot);
+
+    if(scanf("%d", &num_queries) != 1) num_queries = 0;
+    for (int i = 0; i < num_queries; i++)
+    {
+        char command[16];
+        scanf("%15s", command);
+        if(strcmp(command, "Find") == 0)
+        {
+            info_t query;
+            scanf("%7s %d %d", competency_code, &year, &semester);
+            fillInfo(&query, competency_code, "", 0, year, semester);
+
+            tnode_t* node = bulk ? NULL : findCompetency(&query);
+            info_t* competency = bulk ? catalogueFind(&query) : (node != NULL) ? node->data : NULL;
+            if(competency == NULL) printf("Not Found\n");
+            else printf("%d %d %s %s\n", competency->year, competency->semester, competency->code, competency->title);
+        }
+        else if(strcmp(command, "Count") == 0 || strcmp(command, "Credits") == 0)
+        {
+            /* Competencies offered from the first semester to the last one, both included */
+            int fromYear, fromSemester, toYear, toSemester;
+            unsigned long creditsBefore, creditsUpTo;
+            scanf("%d %d %d %d", &fromYear, &fromSemester, &toYear, &toSemester);
+
+            int numBefore = 0;
+            int numUpTo = 0;
+            if(bulk)
+            {
+                numBefore = catalogueCountBefore(fromYear, fromSemester, 0, &creditsBefore);
+                numUpTo = catalogueCountBefore(toYear, toSemester, 1, &creditsUpTo);
+            }
+            else
+            {
+                numBefore = countBefore(fromYear, fromSemester, 0, &creditsBefore);
+                numUpTo = countBefore(toYear, toSemester, 1, &creditsUpTo);
+            }
+            if(numUpTo < numBefore) /* Empty range */
+            {
+                numUpTo = numBefore;
+                creditsUpTo = creditsBefore;
+            }
+            if(strcmp(command, "Count") == 0) printf("%d\n", numUpTo - numBefore);
+            else printf("%lu\n", creditsUpTo - creditsBefore);
+        }
+        else if(strcmp(command, "Kth") == 0)
+        {
+            int k;
+            scanf("%d", &k);
+            tnode_t* node = bulk ? NULL : kthCompetency(k);
+            info_t* competency = bulk ? ((k >= 1 && k <= catalogue.count) ? &catalogue.records[k - 1] : NULL) :
+                (node != NULL) ? node->data : NULL;
+            if(competency == NULL) printf("Not Found\n");
+            else printf("%d %d %s %s\n", competency->year, competency->semester, competency->code, competency->title);
+        }
+    }
+
+    freeAll(treeRoot); /* Every node was allocated, the root included */
+    treeRoot = NULL;
+    freeCatalogue();
+    return 0;
 }
\ No newline at end of file
@@ -0,0 +1,235 @@
+/*
+	AICE Tree Packed Key and Catalogue Benchmark
+	Builds large, deep competency trees with the insert in aiceTree.c and looks
+	every competency up again, once comparing field by field (Every key forced to
+	KEY_UNPACKED) and once comparing the packed 64-bit keys. Codes share long
+	prefixes, so the field by field compare has to run strcmp deep into them.
+	Then sorts the same competencies into the read-optimized catalogue and runs
+	the same lookups and an ordered walk on both layouts. Last, answers credit
+	range queries from the subtree aggregates and checks them against a full walk.
+
+	Build: gcc -O2 -pthread -o aiceTreeBench aiceTreeBench.c
+	Usage: ./aiceTreeBench [numRecords] [numLookups]
+*/
+
+#define main aiceTreeMain
+#include "aiceTree.c"
+#undef main
+
+#include <time.h>
+
+/*
+elapsedSeconds: Returns the seconds elapsed between two timestamps.
+@param start: The earlier timestamp
+@param end: The later timestamp
+@return: Elapsed time in seconds
+*/
+double elapsedSeconds(struct timespec start, struct timespec end)
+{
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/*
+makeCompetency: Creates the i-th competency of the benchmark, in sorted order.
+	Every semester holds 200000 codes that only differ in their last characters.
+@param i: Index of the competency
+@param packed: 0 to force the field by field compare
+@return: Pointer to the competency info
+*/
+info_t* makeCompetency(int i, int packed)
+{
+	char code[8];
+	int k = i % 200000;
+	sprintf(code, "AI%c%c%c%c", 'A' + k / 17576 % 26, 'A' + k / 676 % 26, 'A' + k / 26 % 26, 'A' + k % 26);
+	info_t* competency = createNode(code, "Benchmark", 3, 2000 + i / 400000, (i / 200000) % 2);
+	if(!packed)
+	{
+		competency->key = KEY_UNPACKED;
+	}
+	return competency;
+}
+
+/*
+sumCredits: Adds up the credits of a tree/subtree using In-order traversal.
+@param root: Pointer to the root of the tree/subtree
+@return: The total credits
+*/
+long sumCredits(tnode_t* root)
+{
+	if(root == NULL) return 0;
+	return sumCredits(root->leftChild) + ((info_t*)root->data)->credit + sumCredits(root->rightChild);
+}
+
+/*
+walkRange: Counts the competencies of a tree/subtree offered within a range of semesters
+	and adds up their credits, visiting every node (In-order traversal).
+@param root: Pointer to the root of the tree/subtree
+@param fromYear: The year of the first semester
+@param fromSemester: The first semester within that year
+@param toYear: The year of the last semester
+@param toSemester: The last semester within that year
+@param credits: Credits of the competencies counted are added to it
+@return: The number of competencies within the range
+*/
+int walkRange(tnode_t* root, int fromYear, int fromSemester, int toYear, int toSemester, unsigned long* credits)
+{
+	if(root == NULL) return 0;
+	int count = walkRange(root->leftChild, fromYear, fromSemester, toYear, toSemester, credits);
+	if(compareSemester(root->data, fromYear, fromSemester) >= 0 && compareSemester(root->data, toYear, toSemester) <= 0)
+	{
+		count++;
+		*credits += ((info_t*)root->data)->credit;
+	}
+	return count + walkRange(root->rightChild, fromYear, fromSemester, toYear, toSemester, credits);
+}
+
+int main(int argc, char* argv[])
+{
+	int numRecords = (argc > 1) ? atoi(argv[1]) : 2000000;
+	int numLookups = (argc > 2) ? atoi(argv[2]) : 4000000;
+	int consistent = 1;
+
+	printf("Records: %d, lookups: %d\n", numRecords, numLookups);
+	for (int packed = 0; packed <= 1; ++packed)
+	{
+		info_t** records = malloc(numRecords * sizeof(info_t*));
+		if(records == NULL)
+		{
+			printf("Failed to allocate benchmark state\n");
+			exit(1);
+		}
+		for (int i = 0; i < numRecords; ++i)
+		{
+			records[i] = makeCompetency(i, packed);
+		}
+
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int i = 0; i < numRecords; ++i)
+		{
+			insert(records[i]);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		double buildTime = elapsedSeconds(start, end);
+
+		/* Random lookups, every one of them present */
+		unsigned int seed = 12345;
+		long found = 0;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int i = 0; i < numLookups; ++i)
+		{
+			seed = seed * 1103515245u + 12345u;
+			tnode_t* node = findCompetency(records[(seed >> 4) % numRecords]);
+			found += (node != NULL && node->data == records[(seed >> 4) % numRecords]);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		double lookupTime = elapsedSeconds(start, end);
+		consistent &= (found == numLookups);
+
+		printf("%s: height %d, build %.3f s, lookups %.3f s (%.1f M/s)\n",
+			packed ? "packed keys   " : "field by field", treeRoot->height,
+			buildTime, lookupTime, numLookups / lookupTime / 1e6);
+
+		if(!packed)
+		{
+			freeAll(treeRoot);
+			treeRoot = NULL;
+		}
+		free(records);
+	}
+
+	/* Catalogue of the same competencies, the packed tree is kept for the ordered walk */
+	readRecords = malloc(numRecords * sizeof(info_t));
+	if(readRecords == NULL)
+	{
+		printf("Failed to allocate benchmark state\n");
+		exit(1);
+	}
+	for (int i = 0; i < numRecords; ++i)
+	{
+		info_t* competency = makeCompetency(numRecords - 1 - i, 1); /* Reversed, so the sort has work to do */
+		readRecords[i] = *competency;
+		free(competency);
+	}
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	sortCatalogue(numRecords);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double buildTime = elapsedSeconds(start, end);
+
+	unsigned int seed = 12345;
+	long found = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < numLookups; ++i)
+	{
+		seed = seed * 1103515245u + 12345u;
+		found += (catalogueFind(&catalogue.records[(seed >> 4) % numRecords]) == &catalogue.records[(seed >> 4) % numRecords]);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double lookupTime = elapsedSeconds(start, end);
+	consistent &= (found == numLookups);
+	printf("catalogue     : sort %.3f s, lookups %.3f s (%.1f M/s)\n",
+		buildTime, lookupTime, numLookups / lookupTime / 1e6);
+
+	/* Ordered walk, adding up every credit */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	long treeCredits = sumCredits(treeRoot);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double treeTime = elapsedSeconds(start, end);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	long catalogueCredits = 0;
+	for (int i = 0; i < catalogue.count; ++i)
+	{
+		catalogueCredits += catalogue.records[i].credit;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double catalogueTime = elapsedSeconds(start, end);
+	consistent &= (treeCredits == catalogueCredits);
+	printf("Ordered walk: tree %.4f s, catalogue %.4f s (%.1f GB/s)\n", treeTime, catalogueTime,
+		catalogue.count * sizeof(info_t) / catalogueTime / 1e9);
+
+	/* Credits over a range of semesters, from the aggregates and by walking the whole tree.
+	   Both replay the same queries, the walk only the first numWalks of them */
+	int numYears = numRecords / 400000 + 1;
+	int numWalks = 20;
+	unsigned long aggregateCredits = 0, walkCredits = 0;
+	int aggregateCount = 0, walkCount = 0;
+	double rangeTime[2];
+	for (int walk = 0; walk <= 1; ++walk)
+	{
+		seed = 54321;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int i = 0; i < (walk ? numWalks : numLookups); ++i)
+		{
+			seed = seed * 1103515245u + 12345u;
+			int fromYear = 2000 + (int)((seed >> 4) % numYears);
+			int fromSemester = (seed >> 20) & 1;
+			int toYear = fromYear + (int)((seed >> 12) % 3);
+			if(walk)
+			{
+				walkCount += walkRange(treeRoot, fromYear, fromSemester, toYear, 1, &walkCredits);
+				continue;
+			}
+			unsigned long creditsBefore, creditsUpTo;
+			int numBefore = countBefore(fromYear, fromSemester, 0, &creditsBefore);
+			int numUpTo = countBefore(toYear, 1, 1, &creditsUpTo);
+			if(i < numWalks)
+			{
+				aggregateCount += numUpTo - numBefore;
+				aggregateCredits += creditsUpTo - creditsBefore;
+			}
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		rangeTime[walk] = elapsedSeconds(start, end);
+	}
+	consistent &= (aggregateCount == walkCount && aggregateCredits == walkCredits);
+	printf("Range credits: aggregates %.3f us/query, full walk %.3f ms/query\n",
+		rangeTime[0] / numLookups * 1e6, rangeTime[1] / numWalks * 1e3);
+
+	freeAll(treeRoot);
+	treeRoot = NULL;
+	freeCatalogue();
+
+	printf("Lookups %s\n", consistent ? "match" : "DIFFER");
+	return consistent ? 0 : 1;
+}